@@ -0,0 +1,110 @@
+#include "animcodec.h"
+
+typedef struct
+{
+    const uint8_t *data;
+    const uint8_t *end;
+    uint32_t bits; // Bits not consumed yet, the next bit is bit 0
+    int count;     // Number of valid bits in bits
+    int padding;   // Zero bytes added after the end of the data
+} AnimBitReader;
+
+/**
+ * @brief Make sure at least 24 bits are available, reads zeros past the end of the data
+ *
+ * @param reader
+ */
+static inline void AnimRefill(AnimBitReader *reader)
+{
+	while (reader->count <= 24)
+	{
+		uint32_t byte = 0;
+		if (reader->data < reader->end)
+			byte = *reader->data++;
+		else
+			reader->padding++;
+		reader->bits |= byte << reader->count;
+		reader->count += 8;
+	}
+}
+
+/**
+ * @brief Read bits, the reader must have been refilled with enough bits
+ *
+ * @param reader
+ * @param count From 0 to 24
+ * @return uint32_t
+ */
+static inline uint32_t AnimReadBits(AnimBitReader *reader, int count)
+{
+	uint32_t value = reader->bits & ((1u << count) - 1);
+	reader->bits >>= count;
+	reader->count -= count;
+	return value;
+}
+
+/**
+ * @brief Read a zigzag rice coded value
+ *
+ * @param reader
+ * @param k Rice parameter
+ * @return int
+ */
+static inline int AnimReadRice(AnimBitReader *reader, int k)
+{
+	AnimRefill(reader);
+	// Count the ones of the unary prefix, stopping at the escape length which fits in the refilled bits
+	int quotient = __builtin_ctz(~reader->bits | (1u << ANIM_RICE_ESCAPE));
+	uint32_t zigzag;
+	if (quotient >= ANIM_RICE_ESCAPE)
+	{
+		AnimReadBits(reader, ANIM_RICE_ESCAPE);
+		AnimRefill(reader);
+		zigzag = AnimReadBits(reader, ANIM_RAW_BITS);
+	}
+	else
+	{
+		AnimReadBits(reader, quotient + 1);
+		AnimRefill(reader);
+		zigzag = (quotient << k) | AnimReadBits(reader, k);
+	}
+	return (zigzag >> 1) ^ -(int)(zigzag & 1);
+}
+
+/**
+ * @brief Apply a coded frame to the current grid
+ *
+ * @param data Coded frame
+ * @param size Size of the coded frame in bytes
+ * @param cellCount Number of cells of the grid
+ * @param heights Heights of the previous frame, replaced by the new ones
+ * @param colors RGB15 colors of the previous frame, replaced by the new ones
+ * @return int 0 on success, -1 if the frame is invalid
+ */
+int AnimDecodeFrame(const uint8_t *data, int size, int cellCount, int16_t *heights, uint16_t *colors)
+{
+	if (size < 2)
+		return -1;
+
+	int heightK = data[0];
+	int colorK = data[1];
+	if (heightK > 15 || colorK > 15)
+		return -1;
+
+	AnimBitReader reader = {data + 2, data + size, 0, 0, 0};
+	for (int i = 0; i < cellCount; i++)
+	{
+		heights[i] += AnimReadRice(&reader, heightK);
+
+		int color = colors[i];
+		int red = (color & 31) + AnimReadRice(&reader, colorK);
+		int green = ((color >> 5) & 31) + AnimReadRice(&reader, colorK);
+		int blue = ((color >> 10) & 31) + AnimReadRice(&reader, colorK);
+		colors[i] = (red & 31) | ((green & 31) << 5) | ((blue & 31) << 10);
+	}
+
+	// Using the zero padding means the frame was cut
+	if (reader.count < reader.padding * 8)
+		return -1;
+	return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef ANIMCODEC_H_ /* Include guard */
+#define ANIMCODEC_H_
+
+// Shared by the game and the host tool, only uses the standard headers
+#include <stdint.h>
+
+// 'WANM' in little endian
+#define ANIM_MAGIC 0x4D4E4157
+#define ANIM_VERSION 1
+// Unary prefix length that switches to a raw value
+#define ANIM_RICE_ESCAPE 16
+#define ANIM_RAW_BITS 20
+
+/*
+ * Water animation file:
+ * - AnimHeader
+ * - u32 frame offsets from the start of the file, frameCount + 1 entries (the last one is the end of the file)
+ * - Frames: u8 height rice parameter, u8 color rice parameter, then a bit stream of
+ *   zigzag rice coded deltas from the previous frame, for every cell:
+ *   height, red, green, blue. The first frame is coded from an all zero grid.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint8_t width;
+    uint8_t height;
+    uint16_t frameCount;
+    uint16_t frameStep;    // 60 Hz frames per animation frame
+    uint32_t maxFrameSize; // Size of the biggest coded frame in bytes
+} AnimHeader;
+
+int AnimDecodeFrame(const uint8_t *data, int size, int cellCount, int16_t *heights, uint16_t *colors);
+
+#endif // ANIMCODEC_H_
@@ -0,0 +1,61 @@
+#include "arena.h"
+#include <string.h>
+
+static uint8_t arenaBuffer[ARENA_SIZE] __attribute__((aligned(ARENA_ALIGNMENT)));
+
+ArenaStats arenaStats[ARENA_SUBSYSTEM_COUNT];
+const char *arenaSubsystemNames[ARENA_SUBSYSTEM_COUNT] = {
+	[ARENA_WATER_GRIDS] = "Grids",
+	[ARENA_FBM] = "fBm",
+	[ARENA_CHUNKS] = "Chunks",
+	[ARENA_WATER_ANIM] = "Anim",
+	[ARENA_PIPES] = "Pipes",
+	[ARENA_PARTICLES] = "Spray",
+	[ARENA_SKY] = "Sky",
+	[ARENA_SAND_LIST] = "SandDL",
+};
+// Bytes used in the arena, including the alignment padding
+int arenaUsed = 0;
+// Allocations that did not fit, the arena size has to grow if this is not 0
+int arenaFailedAllocations = 0;
+
+/**
+ * @brief Allocate memory for a subsystem, the memory is never freed one allocation at a time
+ *
+ * @param subsystem Subsystem to count the memory for
+ * @param size Size in bytes
+ * @return void* Zeroed memory aligned to ARENA_ALIGNMENT, NULL if the arena is full
+ */
+void *ArenaAlloc(ArenaSubsystem subsystem, int size)
+{
+	int start = (arenaUsed + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+	if (size < 0 || start + size > ARENA_SIZE)
+	{
+		arenaFailedAllocations++;
+		return NULL;
+	}
+
+	ArenaStats *stats = &arenaStats[subsystem];
+	stats->used += start + size - arenaUsed;
+	stats->allocations++;
+	arenaUsed = start + size;
+
+	void *memory = &arenaBuffer[start];
+	memset(memory, 0, size);
+	return memory;
+}
+
+/**
+ * @brief Write the memory use of every subsystem
+ *
+ * @param file
+ */
+void ArenaDump(FILE *file)
+{
+	fprintf(file, "Arena: %d/%d bytes used, %d failed allocations\n", arenaUsed, ARENA_SIZE, arenaFailedAllocations);
+	for (int i = 0; i < ARENA_SUBSYSTEM_COUNT; i++)
+	{
+		ArenaStats *stats = &arenaStats[i];
+		fprintf(file, "%-8s used %6d, %d allocations\n", arenaSubsystemNames[i], stats->used, stats->allocations);
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef ARENA_H_ /* Include guard */
+#define ARENA_H_
+
+// Shared by the game and the host tools, only uses the standard headers
+#include <stdint.h>
+#include <stdio.h>
+
+// Memory shared by all the subsystems, allocated at startup
+#define ARENA_SIZE (64 * 1024)
+// Alignment of every allocation, a cache line so buffers can be flushed for DMA
+#define ARENA_ALIGNMENT 32
+
+typedef enum
+{
+    ARENA_WATER_GRIDS,
+    ARENA_FBM,
+    ARENA_CHUNKS,
+    ARENA_WATER_ANIM,
+    ARENA_PIPES,
+    ARENA_PARTICLES,
+    ARENA_SKY,
+    ARENA_SAND_LIST,
+    ARENA_SUBSYSTEM_COUNT
+} ArenaSubsystem;
+
+typedef struct
+{
+    int used;        // Bytes allocated, the allocations are never freed
+    int allocations; // Number of allocations
+} ArenaStats;
+
+extern ArenaStats arenaStats[ARENA_SUBSYSTEM_COUNT];
+extern const char *arenaSubsystemNames[ARENA_SUBSYSTEM_COUNT];
+extern int arenaUsed;
+extern int arenaFailedAllocations;
+
+void *ArenaAlloc(ArenaSubsystem subsystem, int size);
+void ArenaDump(FILE *file);
+
+#endif // ARENA_H_
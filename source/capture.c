@@ -0,0 +1,437 @@
+#include "capture.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef ARM9
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//---------------------------------------------------------------------
+// Frames
+
+/**
+ * @brief Allocate the grids of a frame
+ *
+ * @param frame
+ * @param cellCount
+ * @return int 0 on success, -1 if out of memory
+ */
+int CaptureFrameAlloc(CaptureFrame *frame, int cellCount)
+{
+	frame->heights = calloc(cellCount, sizeof(int32_t));
+	frame->colors = calloc(cellCount, sizeof(uint16_t));
+	frame->sand = calloc(cellCount, sizeof(int32_t));
+	memset(frame->timers, 0, sizeof(frame->timers));
+	if (!frame->heights || !frame->colors || !frame->sand)
+	{
+		CaptureFrameFree(frame);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Free the grids of a frame
+ *
+ * @param frame
+ */
+void CaptureFrameFree(CaptureFrame *frame)
+{
+	free(frame->heights);
+	free(frame->colors);
+	free(frame->sand);
+	frame->heights = NULL;
+	frame->colors = NULL;
+	frame->sand = NULL;
+}
+
+/**
+ * @brief Clear the grids and timers of a frame
+ *
+ * @param frame
+ * @param cellCount
+ */
+static void CaptureFrameClear(CaptureFrame *frame, int cellCount)
+{
+	memset(frame->heights, 0, cellCount * sizeof(int32_t));
+	memset(frame->colors, 0, cellCount * sizeof(uint16_t));
+	memset(frame->sand, 0, cellCount * sizeof(int32_t));
+	memset(frame->timers, 0, sizeof(frame->timers));
+}
+
+//---------------------------------------------------------------------
+// Writer
+
+/**
+ * @brief Append a zigzag LEB128 delta to the current chunk
+ *
+ * @param writer
+ * @param delta
+ * @return int 0 on success, -1 if out of memory
+ */
+static int CaptureWriteDelta(CaptureWriter *writer, int32_t delta)
+{
+	// 5 bytes is the longest encoding of 32 bits
+	if (writer->chunkSize + 5 > writer->chunkCapacity)
+	{
+		int capacity = writer->chunkCapacity ? writer->chunkCapacity * 2 : 4096;
+		uint8_t *chunk = realloc(writer->chunk, capacity);
+		if (!chunk)
+			return -1;
+		writer->chunk = chunk;
+		writer->chunkCapacity = capacity;
+	}
+
+	uint32_t value = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+	while (value >= 0x80)
+	{
+		writer->chunk[writer->chunkSize++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	writer->chunk[writer->chunkSize++] = value;
+	return 0;
+}
+
+/**
+ * @brief Write the current chunk to the file and start a new one
+ *
+ * @param writer
+ * @return int 0 on success, -1 on error
+ */
+static int CaptureFlushChunk(CaptureWriter *writer)
+{
+	if (writer->chunkFrameCount == 0)
+		return 0;
+
+	if (writer->chunkCount == writer->chunkOffsetCapacity)
+	{
+		int capacity = writer->chunkOffsetCapacity ? writer->chunkOffsetCapacity * 2 : 64;
+		uint32_t *offsets = realloc(writer->chunkOffsets, capacity * sizeof(uint32_t));
+		if (!offsets)
+			return -1;
+		writer->chunkOffsets = offsets;
+		writer->chunkOffsetCapacity = capacity;
+	}
+	writer->chunkOffsets[writer->chunkCount++] = ftell(writer->file);
+
+	CaptureChunkHeader chunkHeader = {CAPTURE_CHUNK_MAGIC, writer->frameCount - writer->chunkFrameCount, writer->chunkFrameCount, writer->chunkSize};
+	if (fwrite(&chunkHeader, sizeof(chunkHeader), 1, writer->file) != 1 ||
+		fwrite(writer->chunk, 1, writer->chunkSize, writer->file) != (size_t)writer->chunkSize)
+		return -1;
+
+	writer->chunkSize = 0;
+	writer->chunkFrameCount = 0;
+	return 0;
+}
+
+/**
+ * @brief Create a capture file
+ *
+ * @param writer
+ * @param path
+ * @param width Grid width
+ * @param height Grid height
+ * @param timerCount Number of timers per frame, up to CAPTURE_MAX_TIMERS
+ * @return int 0 on success, -1 on error
+ */
+int CaptureWriterOpen(CaptureWriter *writer, const char *path, int width, int height, int timerCount)
+{
+	memset(writer, 0, sizeof(CaptureWriter));
+	if (width < 1 || width > 255 || height < 1 || height > 255 || timerCount < 0 || timerCount > CAPTURE_MAX_TIMERS)
+		return -1;
+
+	if (CaptureFrameAlloc(&writer->previous, width * height) != 0)
+		return -1;
+
+	writer->file = fopen(path, "wb");
+	if (!writer->file)
+	{
+		CaptureFrameFree(&writer->previous);
+		return -1;
+	}
+
+	CaptureHeader header = {CAPTURE_MAGIC, CAPTURE_VERSION, width, height, CAPTURE_CHUNK_FRAMES, timerCount};
+	writer->header = header;
+	if (fwrite(&header, sizeof(header), 1, writer->file) != 1)
+	{
+		fclose(writer->file);
+		writer->file = NULL;
+		CaptureFrameFree(&writer->previous);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Add a frame to the capture
+ *
+ * @param writer
+ * @param frame
+ * @return int 0 on success, -1 on error
+ */
+int CaptureWriterAddFrame(CaptureWriter *writer, const CaptureFrame *frame)
+{
+	if (!writer->file)
+		return -1;
+
+	int cellCount = writer->header.width * writer->header.height;
+	CaptureFrame *previous = &writer->previous;
+	// The first frame of a chunk is coded from zero
+	if (writer->chunkFrameCount == 0)
+		CaptureFrameClear(previous, cellCount);
+
+	int error = 0;
+	for (int i = 0; i < cellCount; i++)
+	{
+		error |= CaptureWriteDelta(writer, frame->heights[i] - previous->heights[i]);
+		error |= CaptureWriteDelta(writer, frame->colors[i] - previous->colors[i]);
+		error |= CaptureWriteDelta(writer, frame->sand[i] - previous->sand[i]);
+	}
+	for (int i = 0; i < writer->header.timerCount; i++)
+		error |= CaptureWriteDelta(writer, frame->timers[i] - previous->timers[i]);
+	if (error)
+		return -1;
+
+	memcpy(previous->heights, frame->heights, cellCount * sizeof(int32_t));
+	memcpy(previous->colors, frame->colors, cellCount * sizeof(uint16_t));
+	memcpy(previous->sand, frame->sand, cellCount * sizeof(int32_t));
+	memcpy(previous->timers, frame->timers, sizeof(previous->timers));
+
+	writer->frameCount++;
+	writer->chunkFrameCount++;
+	if (writer->chunkFrameCount == CAPTURE_CHUNK_FRAMES)
+		return CaptureFlushChunk(writer);
+	return 0;
+}
+
+/**
+ * @brief Write the last chunk and the index, then close the file
+ *
+ * @param writer
+ * @return int 0 on success, -1 on error
+ */
+int CaptureWriterClose(CaptureWriter *writer)
+{
+	if (!writer->file)
+		return -1;
+
+	int error = CaptureFlushChunk(writer);
+	// Align the index so it can be used in place from a memory map
+	while (!error && ftell(writer->file) % 4 != 0)
+	{
+		if (fputc(0, writer->file) == EOF)
+			error = -1;
+	}
+	if (!error)
+	{
+		uint32_t chunkCount = writer->chunkCount;
+		CaptureTrailer trailer = {ftell(writer->file), CAPTURE_INDEX_MAGIC};
+		if (fwrite(&chunkCount, sizeof(chunkCount), 1, writer->file) != 1 ||
+			fwrite(writer->chunkOffsets, sizeof(uint32_t), chunkCount, writer->file) != chunkCount ||
+			fwrite(&trailer, sizeof(trailer), 1, writer->file) != 1)
+			error = -1;
+	}
+	if (fclose(writer->file) != 0)
+		error = -1;
+	writer->file = NULL;
+
+	CaptureFrameFree(&writer->previous);
+	free(writer->chunk);
+	free(writer->chunkOffsets);
+	writer->chunk = NULL;
+	writer->chunkOffsets = NULL;
+	return error;
+}
+
+//---------------------------------------------------------------------
+// Reader
+
+/**
+ * @brief Read a zigzag LEB128 delta
+ *
+ * @param data Current position, moved after the value
+ * @param end End of the chunk
+ * @param delta
+ * @return int 0 on success, -1 if the data is cut
+ */
+static int CaptureReadDelta(const uint8_t **data, const uint8_t *end, int32_t *delta)
+{
+	uint32_t value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		if (*data >= end)
+			return -1;
+		uint8_t byte = *(*data)++;
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			*delta = (value >> 1) ^ -(int32_t)(value & 1);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief Open a capture file for random frame access
+ *
+ * @param reader
+ * @param path
+ * @return int 0 on success, -1 on error
+ */
+int CaptureReaderOpen(CaptureReader *reader, const char *path)
+{
+	memset(reader, 0, sizeof(CaptureReader));
+
+#ifdef ARM9
+	// No memory mapping on the DS, load the whole file
+	FILE *file = fopen(path, "rb");
+	if (!file)
+		return -1;
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	uint8_t *data = size > 0 ? malloc(size) : NULL;
+	if (!data || fread(data, 1, size, file) != (size_t)size)
+	{
+		free(data);
+		fclose(file);
+		return -1;
+	}
+	fclose(file);
+	reader->data = data;
+	reader->size = size;
+	reader->mapped = 0;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	struct stat status;
+	if (fstat(fd, &status) != 0 || status.st_size <= 0)
+	{
+		close(fd);
+		return -1;
+	}
+	void *data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return -1;
+	reader->data = data;
+	reader->size = status.st_size;
+	reader->mapped = 1;
+#endif
+
+	// Check the header, the trailer and the index
+	CaptureTrailer trailer;
+	uint32_t chunkCount;
+	if (reader->size < sizeof(CaptureHeader) + sizeof(uint32_t) + sizeof(CaptureTrailer))
+		goto invalid;
+	memcpy(&reader->header, reader->data, sizeof(CaptureHeader));
+	memcpy(&trailer, reader->data + reader->size - sizeof(CaptureTrailer), sizeof(CaptureTrailer));
+	if (reader->header.magic != CAPTURE_MAGIC || reader->header.version != CAPTURE_VERSION ||
+		reader->header.timerCount > CAPTURE_MAX_TIMERS || reader->header.chunkFrames == 0 ||
+		trailer.magic != CAPTURE_INDEX_MAGIC || trailer.indexOffset % 4 != 0 ||
+		trailer.indexOffset + sizeof(uint32_t) > reader->size - sizeof(CaptureTrailer))
+		goto invalid;
+
+	memcpy(&chunkCount, reader->data + trailer.indexOffset, sizeof(uint32_t));
+	if ((uint64_t)trailer.indexOffset + sizeof(uint32_t) * (chunkCount + 1) != reader->size - sizeof(CaptureTrailer))
+		goto invalid;
+	reader->chunkOffsets = (const uint32_t *)(reader->data + trailer.indexOffset + sizeof(uint32_t));
+	reader->chunkCount = chunkCount;
+
+	// Every chunk but the last one is full
+	if (chunkCount > 0)
+	{
+		uint32_t lastOffset = reader->chunkOffsets[chunkCount - 1];
+		if (lastOffset + sizeof(CaptureChunkHeader) > trailer.indexOffset)
+			goto invalid;
+		CaptureChunkHeader lastChunk;
+		memcpy(&lastChunk, reader->data + lastOffset, sizeof(CaptureChunkHeader));
+		reader->frameCount = lastChunk.firstFrame + lastChunk.frameCount;
+	}
+	return 0;
+
+invalid:
+	CaptureReaderClose(reader);
+	return -1;
+}
+
+/**
+ * @brief Decode a frame, only the frames before it in its chunk are decoded
+ *
+ * @param reader
+ * @param index Frame index
+ * @param frame Allocated with CaptureFrameAlloc for the grid size of the capture
+ * @return int 0 on success, -1 on error
+ */
+int CaptureReaderGetFrame(const CaptureReader *reader, uint32_t index, CaptureFrame *frame)
+{
+	if (index >= reader->frameCount)
+		return -1;
+
+	uint32_t chunkIndex = index / reader->header.chunkFrames;
+	if (chunkIndex >= reader->chunkCount)
+		return -1;
+
+	uint32_t offset = reader->chunkOffsets[chunkIndex];
+	if (offset + sizeof(CaptureChunkHeader) > reader->size)
+		return -1;
+	CaptureChunkHeader chunkHeader;
+	memcpy(&chunkHeader, reader->data + offset, sizeof(CaptureChunkHeader));
+	const uint8_t *data = reader->data + offset + sizeof(CaptureChunkHeader);
+	const uint8_t *end = data + chunkHeader.size;
+	if (chunkHeader.magic != CAPTURE_CHUNK_MAGIC || end > reader->data + reader->size ||
+		index < chunkHeader.firstFrame || index >= chunkHeader.firstFrame + chunkHeader.frameCount)
+		return -1;
+
+	int cellCount = reader->header.width * reader->header.height;
+	CaptureFrameClear(frame, cellCount);
+	for (uint32_t f = chunkHeader.firstFrame; f <= index; f++)
+	{
+		int32_t delta;
+		for (int i = 0; i < cellCount; i++)
+		{
+			if (CaptureReadDelta(&data, end, &delta) != 0)
+				return -1;
+			frame->heights[i] += delta;
+			if (CaptureReadDelta(&data, end, &delta) != 0)
+				return -1;
+			frame->colors[i] += delta;
+			if (CaptureReadDelta(&data, end, &delta) != 0)
+				return -1;
+			frame->sand[i] += delta;
+		}
+		for (int i = 0; i < reader->header.timerCount; i++)
+		{
+			if (CaptureReadDelta(&data, end, &delta) != 0)
+				return -1;
+			frame->timers[i] += delta;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Release the file data
+ *
+ * @param reader
+ */
+void CaptureReaderClose(CaptureReader *reader)
+{
+	if (reader->data)
+	{
+#ifdef ARM9
+		free((void *)reader->data);
+#else
+		if (reader->mapped)
+			munmap((void *)reader->data, reader->size);
+		else
+			free((void *)reader->data);
+#endif
+	}
+	memset(reader, 0, sizeof(CaptureReader));
+}
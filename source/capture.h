@@ -0,0 +1,96 @@
+#ifndef CAPTURE_H_ /* Include guard */
+#define CAPTURE_H_
+
+// Shared by the game and the host tools, only uses the standard headers
+#include <stdint.h>
+#include <stdio.h>
+
+// 'WCAP', 'CHNK' and 'WIDX' in little endian
+#define CAPTURE_MAGIC 0x50414357
+#define CAPTURE_CHUNK_MAGIC 0x4B4E4843
+#define CAPTURE_INDEX_MAGIC 0x58444957
+#define CAPTURE_VERSION 1
+// Frames per chunk, the first frame of a chunk is coded from zero for random access
+#define CAPTURE_CHUNK_FRAMES 32
+#define CAPTURE_MAX_TIMERS 8
+
+/*
+ * Capture file:
+ * - CaptureHeader
+ * - Chunks: CaptureChunkHeader then the frames of the chunk. A frame is a list of
+ *   zigzag LEB128 deltas from the previous frame of the chunk: for every cell the
+ *   water height, water color and sand height, then every timer.
+ * - Index: chunk count, then the file offset of every chunk header (u32)
+ * - CaptureTrailer
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint8_t width;
+    uint8_t height;
+    uint16_t chunkFrames;
+    uint16_t timerCount;
+} CaptureHeader;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t firstFrame;
+    uint32_t frameCount;
+    uint32_t size; // Size of the coded frames after this header
+} CaptureChunkHeader;
+
+typedef struct
+{
+    uint32_t indexOffset;
+    uint32_t magic;
+} CaptureTrailer;
+
+// One uncoded frame
+typedef struct
+{
+    int32_t *heights;  // Water finalHeight, width * height values
+    uint16_t *colors;  // Water color, width * height values
+    int32_t *sand;     // Sand intHeight, width * height values
+    uint32_t timers[CAPTURE_MAX_TIMERS]; // Profiler ticks
+} CaptureFrame;
+
+typedef struct
+{
+    FILE *file;
+    CaptureHeader header;
+    uint32_t frameCount;
+    CaptureFrame previous; // Last frame written in the chunk
+    uint8_t *chunk;        // Coded frames of the current chunk
+    int chunkSize;
+    int chunkCapacity;
+    int chunkFrameCount;
+    uint32_t *chunkOffsets;
+    int chunkCount;
+    int chunkOffsetCapacity;
+} CaptureWriter;
+
+typedef struct
+{
+    const uint8_t *data; // Whole file, mapped or loaded
+    uint32_t size;
+    CaptureHeader header;
+    const uint32_t *chunkOffsets;
+    uint32_t chunkCount;
+    uint32_t frameCount;
+    int mapped; // The data is a memory map, not a loaded copy
+} CaptureReader;
+
+int CaptureFrameAlloc(CaptureFrame *frame, int cellCount);
+void CaptureFrameFree(CaptureFrame *frame);
+
+int CaptureWriterOpen(CaptureWriter *writer, const char *path, int width, int height, int timerCount);
+int CaptureWriterAddFrame(CaptureWriter *writer, const CaptureFrame *frame);
+int CaptureWriterClose(CaptureWriter *writer);
+
+int CaptureReaderOpen(CaptureReader *reader, const char *path);
+int CaptureReaderGetFrame(const CaptureReader *reader, uint32_t index, CaptureFrame *frame);
+void CaptureReaderClose(CaptureReader *reader);
+
+#endif // CAPTURE_H_
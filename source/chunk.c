@@ -0,0 +1,130 @@
+#include "chunk.h"
+#include "draw3d.h"
+#include "noise.h"
+#include "profiler.h"
+#include "arena.h"
+
+// Sand noise offset, the same terrain as the original fixed grid at the world origin
+#define SAND_X_OFFSET 10
+#define SAND_Y_OFFSET 5
+
+SandChunk *chunkCache = NULL;
+u32 chunkUseStamp = 0;
+// Lookups since the init
+u32 chunkCacheHits = 0;
+u32 chunkCacheMisses = 0;
+
+/**
+ * @brief Empty the cache
+ *
+ */
+void ChunkCacheInit()
+{
+	if (!chunkCache)
+	{
+		chunkCache = ArenaAlloc(ARENA_CHUNKS, CHUNK_CACHE_SIZE * sizeof(SandChunk));
+		sassert(chunkCache, "Arena full: sand chunks");
+	}
+	for (int i = 0; i < CHUNK_CACHE_SIZE; i++)
+		chunkCache[i].valid = false;
+	chunkUseStamp = 0;
+	chunkCacheHits = 0;
+	chunkCacheMisses = 0;
+}
+
+/**
+ * @brief Generate the sand of a chunk from noise
+ *
+ * @param chunk
+ */
+void ChunkGenerate(SandChunk *chunk)
+{
+	ProfilerBegin(PROFILER_SECTION_CHUNK_GENERATION);
+	int startX = chunk->chunkX * CHUNK_SIZE + SAND_X_OFFSET;
+	int startY = chunk->chunkY * CHUNK_SIZE + SAND_Y_OFFSET;
+	for (int x = 0; x < CHUNK_SIZE; x++)
+	{
+		for (int y = 0; y < CHUNK_SIZE; y++)
+		{
+			SandPoint *point = &chunk->sand[x][y];
+			// Set sand height from noise
+			point->height = noise2((startX + x) / 4.0, (startY + y) / 4.0) * 2 - 1;
+			// Get height int version for fast water simulation
+			point->intHeight = point->height * 4096;
+			// The sand never changes so the caustics tint is only computed here
+			point->causticsColor = CausticsColor(point->intHeight);
+		}
+	}
+	ProfilerEnd(PROFILER_SECTION_CHUNK_GENERATION);
+}
+
+/**
+ * @brief Get a chunk from the cache, generating it in the least recently used slot if needed
+ *
+ * @param chunkX
+ * @param chunkY
+ * @return SandChunk*
+ */
+SandChunk *ChunkGet(int chunkX, int chunkY)
+{
+	chunkUseStamp++;
+	SandChunk *oldest = NULL;
+	for (int i = 0; i < CHUNK_CACHE_SIZE; i++)
+	{
+		SandChunk *chunk = &chunkCache[i];
+		if (chunk->valid && chunk->chunkX == chunkX && chunk->chunkY == chunkY)
+		{
+			chunk->lastUse = chunkUseStamp;
+			chunkCacheHits++;
+			return chunk;
+		}
+
+		// Free slots first, then the least recently used
+		if (!oldest || (oldest->valid && (!chunk->valid || chunk->lastUse < oldest->lastUse)))
+			oldest = chunk;
+	}
+
+	chunkCacheMisses++;
+	oldest->chunkX = chunkX;
+	oldest->chunkY = chunkY;
+	oldest->valid = true;
+	oldest->lastUse = chunkUseStamp;
+	ChunkGenerate(oldest);
+	return oldest;
+}
+
+/**
+ * @brief Copy the sand of the chunks under the grid in sandHeight
+ *
+ * @param worldX World cell of the first grid point on x
+ * @param worldY World cell of the first grid point on y
+ */
+void ChunkFillSand(int worldX, int worldY)
+{
+	// Copy one chunk overlap at a time
+	for (int x = 0; x < WATER_SIZE;)
+	{
+		int cellX = worldX + x;
+		int localX = cellX & (CHUNK_SIZE - 1);
+		int countX = CHUNK_SIZE - localX;
+		if (countX > WATER_SIZE - x)
+			countX = WATER_SIZE - x;
+
+		for (int y = 0; y < WATER_SIZE;)
+		{
+			int cellY = worldY + y;
+			int localY = cellY & (CHUNK_SIZE - 1);
+			int countY = CHUNK_SIZE - localY;
+			if (countY > WATER_SIZE - y)
+				countY = WATER_SIZE - y;
+
+			// Arithmetic shift to round negative cells down
+			SandChunk *chunk = ChunkGet(cellX >> CHUNK_SHIFT, cellY >> CHUNK_SHIFT);
+			for (int i = 0; i < countX; i++)
+				memcpy(&sandHeight[x + i][y], &chunk->sand[localX + i][localY], countY * sizeof(SandPoint));
+
+			y += countY;
+		}
+		x += countX;
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef CHUNK_H_ /* Include guard */
+#define CHUNK_H_
+
+// Shared by the game and the host tools, only uses the standard headers
+#include <stdbool.h>
+#include <stdint.h>
+#include "water.h"
+
+// Only the sand is chunked, the water is computed every step from noise that is continuous over the world
+// Cells per chunk side, a power of two
+#define CHUNK_SHIFT 3
+#define CHUNK_SIZE (1 << CHUNK_SHIFT)
+// Resident chunks, enough for the chunks under the grid plus a border to come back to
+#define CHUNK_CACHE_SIZE 16
+
+typedef struct
+{
+    int chunkX;       // Chunk coordinates in chunks
+    int chunkY;
+    uint32_t lastUse; // Lookup stamp for the LRU eviction
+    bool valid;
+    SandPoint sand[CHUNK_SIZE][CHUNK_SIZE];
+} SandChunk;
+
+extern uint32_t chunkCacheHits;
+extern uint32_t chunkCacheMisses;
+
+void ChunkCacheInit();
+void ChunkFillSand(int worldX, int worldY);
+
+#endif // CHUNK_H_
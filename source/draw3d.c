@@ -1,375 +1,485 @@
 #include "draw3d.h"
 #include "noise.h"
-#include <math.h>
+#include "trig.h"
+#include "gerstner.h"
+#include "fbm.h"
+#include "profiler.h"
+#include "simclock.h"
+#include "wateranim.h"
+#include "chunk.h"
+#include "arena.h"
+#include "pipes.h"
+#include "particles.h"
+#include "waterkernels.h"
+#include "scenedraw.h"
+#include "skymap.h"
+#include "flowmap.h"
 
 // Asset from https://www.kenney.nl/assets/topdown-tanks-redux
-#include "crateWood_bin.h"
-#include "tileSand_bin.h"
+// Textures converted to DS formats by grit at build time, see graphics/
+#include "crateWood.h"
+#include "tileSand.h"
+#include "caustics.h"
+#include "sky.h"
 
 // Camera variables
 NE_Camera *Camera;
-float angle = 0;
+// Camera angle in binary angle units, after the last simulation step and before it
+int angle = 0;
+int previousAngle = 0;
+// About 0.003 radians per frame
+#define CAMERA_ROTATION_SPEED 31
+// Camera of the map drawn on the bottom screen in dual screen mode, above the middle of the grid
+NE_Camera *mapCamera;
+// High enough for the whole grid to fit in the field of view
+#define MAP_CAMERA_HEIGHT 24
 
 // All water points
-WaterPoint water[WATER_SIZE][WATER_SIZE];
+WaterPoint (*water)[WATER_SIZE] = NULL;
 // All sand height points
-SandPoint sandHeight[WATER_SIZE][WATER_SIZE];
+SandPoint (*sandHeight)[WATER_SIZE] = NULL;
 // Water noise offset
 float waterXOff = 0;
 float waterYOff = 0;
 int waterGridXOff = 0;
 int waterGridYOff = 0;
-
-#define WAVE_HEIGHT 6
-#define SAND_HEIGHT 3
-#define WAVE_HEIGHT_INT (WAVE_HEIGHT * 4096)
-#define SAND_HEIGHT_INT (SAND_HEIGHT * 4096)
-
-#define CUBE_VERTEX_COUNT 72 / 3
-#define COLOR_WHITE RGB15(31, 31, 31)
+// World cell of the first grid point
+int worldX = 0;
+int worldY = 0;
+// Currents of the flow mode, baked from the sand under the grid
+FlowVector *waterFlow = NULL;
+// Time of the simplex water mode in 20.12 fixed point, about a noise unit every 3 seconds, also the phase of the flow mode
+int waterTime = 0;
+#define WATER_TIME_SPEED 24
+
+// Textures of the graphics directory
+#define TILE_SAND_TEXTURE_SIZE 128
+#define CRATE_WOOD_TEXTURE_SIZE 64
+#define TEXTURE_FLAGS (NE_TEXGEN_TEXCOORD | NE_TEXTURE_WRAP_S | NE_TEXTURE_WRAP_T)
+
+// Caustics scroll per 60 Hz frame in 1/16 texel
+#define CAUSTICS_SCROLL_U 5
+#define CAUSTICS_SCROLL_V 3
+// Mean water level and depths where the caustics are the brightest and where they disappear
+#define CAUSTICS_WATER_LEVEL (WAVE_HEIGHT_INT / 2)
+#define CAUSTICS_FULL_DEPTH 1024
+#define CAUSTICS_MAX_DEPTH (5 * 4096)
+
+// Rest level of the shallow water, the highest sand stays dry
+#define PIPES_REST_LEVEL 512
+// Depth added by the source and removed by the sink every 60 Hz frame
+#define PIPES_SOURCE_RATE 64
+// Dry points are drawn under the sand
+#define PIPES_DRY_OFFSET 256
+
+// A point throws spray when it rises above the crest height, or rises faster than the rise height per 60 Hz frame
+#define SPRAY_CREST_HEIGHT 3300
+#define SPRAY_RISE_HEIGHT 60
+#define SPRAY_PER_POINT 2
+#define SPRAY_PER_SPLASH 6
+// Vertical speed of the spray in 20.12 fixed point world units per 60 Hz frame
+#define SPRAY_SPEED 160
+// Point under the cube
+#define CUBE_POINT_X 5
+#define CUBE_POINT_Y 8
 
 // Position of the cube
 float cubeXPos = 10;
 float cubeYPos = 2;
 float cubeZPos = 16;
 
-bool needUpdateWater = false;
-// Clear water rendering style
-bool clearWater = true;
-// Fast water simulation
-bool fastWater = false;
+// A point is updated every waterUpdateInterval simulation steps in Perlin and fast modes
+int waterUpdateInterval = 2;
+int waterUpdatePhase = 0;
+// Point indices used as mesh vertices, every waterMeshStep points plus the last one
+int waterMeshStep = 1;
+int meshIndices[WATER_SIZE];
+int meshIndexCount = 0;
+// Water rendering style
+WaterStyle waterStyle = WATER_STYLE_CLEAR;
+// Water simulation mode
+WaterMode waterMode = WATER_MODE_PERLIN;
+// Shallow water over the sand, cells are stored in the same order as water[x][y]
+PipesGrid waterPipes;
+// Spray thrown by the crests and by the cube
+ParticlePool spray;
+u32 *sprayList = NULL;
+// Sand tiles as a display list, built when the sand or the mesh changes and called by both screens, SCENE_SAND_LIST_WORDS words
+u32 *sandList = NULL;
+// Scene drawn by the top screen after the simulation steps, and drawn again by the map on the bottom screen
+SceneDrawState scene;
 
 // For textures
 NE_Material *materialTileSand = NULL;
 NE_Palette *paletteTileSand = NULL;
 NE_Material *materialCrateWood = NULL;
 NE_Palette *paletteCrateWood = NULL;
+NE_Material *materialCaustics = NULL;
+NE_Palette *paletteCaustics = NULL;
+NE_Material *materialSky = NULL;
+NE_Palette *paletteSky = NULL;
+// Sky texture coordinates of every surface slope, for the sky style, SKY_TABLE_SIZE values
+u32 *skyTable = NULL;
+// Caustics texture offset in 1/16 texel
+int causticsU = 0;
+int causticsV = 0;
 
-// Cube vertices
-int cubeVert[72] = {
-	-1, 1, 1, // 0
-	-1, -1, 1,
-	1, -1, 1,
-	1, 1, 1,
-	1, 1, -1, // 1
-	1, -1, -1,
-	-1, -1, -1,
-	-1, 1, -1,
-	1, 1, 1, // 2
-	1, -1, 1,
-	1, -1, -1,
-	1, 1, -1,
-	-1, 1, -1, // 3
-	-1, -1, -1,
-	-1, -1, 1,
-	-1, 1, 1,
-	1, 1, 1, // 4
-	1, 1, -1,
-	-1, 1, -1,
-	-1, 1, 1,
-	-1, -1, 1, // 5
-	-1, -1, -1,
-	1, -1, -1,
-	1, -1, 1};
-
-// Cube uvs
-u32 cubeUv[] = {
-	TEXTURE_PACK(inttot16(0), inttot16(55)), // 0
-	TEXTURE_PACK(inttot16(0), inttot16(0)),
-	TEXTURE_PACK(inttot16(55), inttot16(0)),
-	TEXTURE_PACK(inttot16(55), inttot16(55)),
-	TEXTURE_PACK(inttot16(55), inttot16(55)), // 1
-	TEXTURE_PACK(inttot16(55), inttot16(0)),
-	TEXTURE_PACK(inttot16(0), inttot16(0)),
-	TEXTURE_PACK(inttot16(0), inttot16(55)),
-	TEXTURE_PACK(inttot16(55), inttot16(55)), // 2
-	TEXTURE_PACK(inttot16(0), inttot16(55)),
-	TEXTURE_PACK(inttot16(0), inttot16(0)),
-	TEXTURE_PACK(inttot16(55), inttot16(0)),
-	TEXTURE_PACK(inttot16(55), inttot16(0)), // 3
-	TEXTURE_PACK(inttot16(0), inttot16(0)),
-	TEXTURE_PACK(inttot16(0), inttot16(55)),
-	TEXTURE_PACK(inttot16(55), inttot16(55)),
-	TEXTURE_PACK(inttot16(55), inttot16(55)), // 4
-	TEXTURE_PACK(inttot16(55), inttot16(0)),
-	TEXTURE_PACK(inttot16(0), inttot16(0)),
-	TEXTURE_PACK(inttot16(0), inttot16(55)),
-	TEXTURE_PACK(inttot16(0), inttot16(55)), // 5
-	TEXTURE_PACK(inttot16(0), inttot16(0)),
-	TEXTURE_PACK(inttot16(55), inttot16(0)),
-	TEXTURE_PACK(inttot16(55), inttot16(55)),
-};
-
-int Lerp(int a, int b, float f)
+/**
+ * @brief Set the camera position based on a camera angle
+ *
+ * @param cameraAngle Angle in binary angle units
+ */
+void SetCameraPosition(int cameraAngle)
 {
-	return a * (1 - f) + (b * f);
+	NE_CameraSetI(Camera,
+				  inttof32(WATER_SIZE) - TrigSinLerp(cameraAngle) * WATER_SIZE, inttof32(12), inttof32(WATER_SIZE) - TrigCosLerp(cameraAngle) * WATER_SIZE,
+				  inttof32(WATER_SIZE), inttof32(1), inttof32(WATER_SIZE),
+				  0, inttof32(1), 0);
 }
 
 /**
- * @brief Set the camera position based on the camera angle
+ * @brief Set the map camera looking down at the middle of the grid, the top of the map is the far side of the grid
  *
  */
-void SetCameraPosition()
+void SetMapCameraPosition()
 {
-	NE_CameraSet(Camera,
-				 WATER_SIZE - sinf(angle) * WATER_SIZE, 12, WATER_SIZE - cosf(angle) * WATER_SIZE,
-				 WATER_SIZE, 1, WATER_SIZE,
-				 0, 1, 0);
+	NE_CameraSetI(mapCamera,
+				  inttof32(WATER_SIZE), inttof32(MAP_CAMERA_HEIGHT), inttof32(WATER_SIZE),
+				  inttof32(WATER_SIZE), 0, inttof32(WATER_SIZE),
+				  0, 0, inttof32(-1));
 }
 
 /**
- * @brief Init graphics
+ * @brief Allocate the water and sand grids and their tables from the arena, stops with an error screen if the arena is too small
  *
  */
-void InitGraphics()
+void AllocateWaterGrids()
 {
-	Camera = NE_CameraCreate();
-
-	SetCameraPosition();
-
-	if (!fastWater)
-	{
-		// Set a random water offset
-		waterXOff = rand() % 10000;
-		waterYOff = rand() % 10000;
-	}
-
-	// Load textures
-	paletteTileSand = NE_PaletteCreate();
-	materialTileSand = NE_MaterialCreate();
-	NE_MaterialTexLoadBMPtoRGB256(materialTileSand, paletteTileSand, (void *)tileSand_bin, 1);
-
-	paletteCrateWood = NE_PaletteCreate();
-	materialCrateWood = NE_MaterialCreate();
-	NE_MaterialTexLoadBMPtoRGB256(materialCrateWood, paletteCrateWood, (void *)crateWood_bin, 1);
+	water = ArenaAlloc(ARENA_WATER_GRIDS, sizeof(WaterPoint) * WATER_SIZE * WATER_SIZE);
+	sandHeight = ArenaAlloc(ARENA_WATER_GRIDS, sizeof(SandPoint) * WATER_SIZE * WATER_SIZE);
+	waterFlow = ArenaAlloc(ARENA_WATER_GRIDS, sizeof(FlowVector) * WATER_SIZE * WATER_SIZE);
+	sassert(water && sandHeight && waterFlow, "Arena full: water grids");
+	skyTable = ArenaAlloc(ARENA_SKY, SKY_TABLE_SIZE * sizeof(u32));
+	sassert(skyTable, "Arena full: sky table");
+	sandList = ArenaAlloc(ARENA_SAND_LIST, SCENE_SAND_LIST_WORDS * sizeof(u32));
+	sassert(sandList, "Arena full: sand display list");
+
+	void *pipesBuffer = ArenaAlloc(ARENA_PIPES, PipesBufferSize(WATER_SIZE, WATER_SIZE));
+	sassert(pipesBuffer, "Arena full: shallow water");
+	PipesInit(&waterPipes, WATER_SIZE, WATER_SIZE, pipesBuffer);
+
+	void *particlesBuffer = ArenaAlloc(ARENA_PARTICLES, ParticlesBufferSize(SPRAY_PARTICLES));
+	sprayList = ArenaAlloc(ARENA_PARTICLES, ParticlesListSize(SPRAY_PARTICLES));
+	sassert(particlesBuffer && sprayList, "Arena full: spray");
+	ParticlesInit(&spray, SPRAY_PARTICLES, particlesBuffer);
 }
 
 /**
- * @brief Set the Water color from a coor
+ * @brief Fill the shallow water with still water over the current sand, with a source and a sink in opposite corners
  *
- * @param x
- * @param y
  */
-void SetWaterColor(int x, int y)
+void ResetWaterPipes()
 {
-	WaterPoint *point = &water[x][y];
-	// Get the difference between the height of the sand and the height of the water
-	int heightDiff = 0;
-	if (!fastWater)
-		heightDiff = (point->height * 2 - (sandHeight[x][y].height)) * 200;
-	else
-		heightDiff = (point->finalHeight * 2 - (sandHeight[x][y].intHeight)) * 200 / 4096;
-
-	// Set color intensity of the basic water color
-	int colorIntensity = 0;
-	if (!fastWater)
-		colorIntensity = point->height * 11;
-	else
-		colorIntensity = point->finalHeight / 4096.0f * 11;
-
-	// If the water is close to the sand
-	if (heightDiff <= 20)
+	for (int x = 0; x < WATER_SIZE; x++)
 	{
-		// If the water is under the sand, the value is lower than 0 so put the value to 0
-		if (heightDiff < 0)
-			heightDiff = 0;
-
-		// Ration for interpolation between the basic water color and the light water color when close to the sand
-		float heightDifRatio = heightDiff / 20.0f;
-		if (clearWater)
-		{
-			int col1 = Lerp(20, colorIntensity, heightDifRatio);
-			int col2 = Lerp(20, 7 + colorIntensity, heightDifRatio);
-			point->color = RGB15(col1, col1, col2);
-		}
-		else
+		for (int y = 0; y < WATER_SIZE; y++)
 		{
-			int col1 = Lerp(20, 5 - colorIntensity / 2, heightDifRatio);
-			int col2 = Lerp(20, 11 - colorIntensity, heightDifRatio);
-			int col3 = Lerp(31, 31 - colorIntensity, heightDifRatio);
-			point->color = RGB15(col1, col2, col3);
+			// Sand height in water height units
+			waterPipes.terrain[x * WATER_SIZE + y] = sandHeight[x][y].intHeight * SAND_HEIGHT / WAVE_HEIGHT;
 		}
 	}
-	else // Basic water color
-	{
-		if (clearWater)
-			point->color = RGB15(colorIntensity, colorIntensity, 7 + colorIntensity);
-		else
-			point->color = RGB15(5 - colorIntensity / 2, 11 - colorIntensity, 31 - colorIntensity);
-	}
+	PipesFillToLevel(&waterPipes, PIPES_REST_LEVEL);
+	PipesClearSources(&waterPipes);
+	PipesAddSource(&waterPipes, 1, 1, PIPES_SOURCE_RATE);
+	PipesAddSource(&waterPipes, WATER_SIZE - 2, WATER_SIZE - 2, -PIPES_SOURCE_RATE);
 }
 
 /**
- * @brief Draw sand ground
+ * @brief Run the shallow water steps of a simulation step and set the water heights
  *
+ * @param frames 60 Hz frames per simulation step
  */
-void DrawSand()
+void UpdateWaterPipes(int frames)
 {
-	NE_PolyFormat(31, 0, NE_LIGHT_0, NE_CULL_NONE, NE_MODULATION);
-	NE_PolyBegin(GL_QUAD);
-	NE_MaterialUse(materialTileSand);
-
-	// Create a plane under the sand to hide artefacts due to float precision
-	glPushMatrix();
-	glTranslatef32(inttov16(WATER_SIZE + 1), inttov16(-2), inttov16(WATER_SIZE + 1));
-	glScalef32(inttov16(WATER_SIZE + 1), inttov16(1), inttov16(WATER_SIZE + 1));
-	GFX_TEX_COORD = TEXTURE_PACK(inttot16(127), inttot16(127));
-	glVertex3v16(inttov16(1), 0, inttov16(1));
-	GFX_TEX_COORD = TEXTURE_PACK(inttot16(127), inttot16(0));
-	glVertex3v16(inttov16(1), 0, inttov16(-1));
-	GFX_TEX_COORD = TEXTURE_PACK(inttot16(0), inttot16(0));
-	glVertex3v16(inttov16(-1), 0, inttov16(-1));
-	GFX_TEX_COORD = TEXTURE_PACK(inttot16(0), inttot16(127));
-	glVertex3v16(inttov16(-1), 0, inttov16(1));
-	glPopMatrix(1);
-
-	// Draw sand tiles
-	glPushMatrix();
-	glScalef32(inttov16(1), SAND_HEIGHT_INT, inttov16(1));
-	for (int x = 1; x < WATER_SIZE; x++)
+	for (int i = 0; i < frames; i++)
+		PipesStep(&waterPipes);
+
+	for (int x = 0; x < WATER_SIZE; x++)
 	{
-		for (int y = 1; y < WATER_SIZE; y++)
+		const int32_t *terrain = &waterPipes.terrain[x * WATER_SIZE];
+		const int32_t *depth = &waterPipes.depth[x * WATER_SIZE];
+		for (int y = 0; y < WATER_SIZE; y++)
 		{
-			glPushMatrix();
-			glTranslatef32(inttov16(x * 2), inttov16(0), inttov16(y * 2));
+			if (depth[y] > 0)
+				water[x][y].finalHeight = terrain[y] + depth[y];
+			else
+				water[x][y].finalHeight = terrain[y] - PIPES_DRY_OFFSET;
+		}
+	}
+}
 
-			GFX_TEX_COORD = TEXTURE_PACK(inttot16(127), inttot16(127));
-			glVertex3v16(inttov16(1), sandHeight[x][y].intHeight, inttov16(1));
+/**
+ * @brief Build the sand display list from the current sand and mesh
+ *
+ */
+void BuildSandList()
+{
+	SceneDrawState sandScene = {
+		.sand = sandHeight,
+		.meshIndices = meshIndices,
+		.meshIndexCount = meshIndexCount,
+	};
+	SceneBuildSandList(&sandScene, sandList);
+}
 
-			GFX_TEX_COORD = TEXTURE_PACK(inttot16(127), inttot16(0));
-			glVertex3v16(inttov16(1), sandHeight[x][y - 1].intHeight, inttov16(-1));
+/**
+ * @brief Set how often points are updated and how many points are used for the meshes
+ *
+ * @param updateInterval Simulation steps between two updates of a point in Perlin and fast modes
+ * @param meshStep Points between two mesh vertices
+ */
+void SetWaterDetail(int updateInterval, int meshStep)
+{
+	if (updateInterval < 1)
+		updateInterval = 1;
+	if (meshStep < 1)
+		meshStep = 1;
+	waterUpdateInterval = updateInterval;
+	waterUpdatePhase %= updateInterval;
+	waterMeshStep = meshStep;
+
+	// Always end on the last point so the mesh covers the whole grid
+	meshIndexCount = 0;
+	for (int i = 0; i < WATER_SIZE - 1; i += meshStep)
+		meshIndices[meshIndexCount++] = i;
+	meshIndices[meshIndexCount++] = WATER_SIZE - 1;
+	BuildSandList();
+}
 
-			GFX_TEX_COORD = TEXTURE_PACK(inttot16(0), inttot16(0));
-			glVertex3v16(inttov16(-1), sandHeight[x - 1][y - 1].intHeight, inttov16(-1));
+/**
+ * @brief Load a square texture and its palette, converted at build time so they are copied to VRAM as they are
+ *
+ * @param material
+ * @param palette
+ * @param format Format of the texels, and of the palette
+ * @param size Width and height in texels
+ * @param texels
+ * @param colors
+ * @param colorsSize Size of the palette in bytes
+ * @param flags
+ */
+void LoadTexture(NE_Material *material, NE_Palette *palette, NE_TextureFormat format, int size, const void *texels, const void *colors, int colorsSize, NE_TextureFlags flags)
+{
+	NE_MaterialTexLoad(material, format, size, size, flags, texels);
+	NE_PaletteLoad(palette, colors, colorsSize / 2, format);
+	NE_MaterialSetPalette(material, palette);
+}
 
-			GFX_TEX_COORD = TEXTURE_PACK(inttot16(0), inttot16(127));
-			glVertex3v16(inttov16(-1), sandHeight[x - 1][y].intHeight, inttov16(1));
+/**
+ * @brief Create the cameras and load the textures, again after the engine is restarted for another screen mode
+ *
+ */
+void LoadGraphics()
+{
+	Camera = NE_CameraCreate();
+	SetCameraPosition(angle);
+	mapCamera = NE_CameraCreate();
+	SetMapCameraPosition();
+	// The materials of the last scene are freed with the engine, the top screen sets a new scene first
+	scene.sandList = NULL;
 
-			glPopMatrix(1);
-		}
-	}
-	glPopMatrix(1);
+	// Load textures
+	ProfilerBegin(PROFILER_SECTION_TEXTURE_LOAD);
+	paletteTileSand = NE_PaletteCreate();
+	materialTileSand = NE_MaterialCreate();
+	LoadTexture(materialTileSand, paletteTileSand, NE_PAL16, TILE_SAND_TEXTURE_SIZE, tileSandBitmap, tileSandPal, tileSandPalLen, TEXTURE_FLAGS);
 
-	NE_PolyEnd();
+	paletteCrateWood = NE_PaletteCreate();
+	materialCrateWood = NE_MaterialCreate();
+	LoadTexture(materialCrateWood, paletteCrateWood, NE_PAL16, CRATE_WOOD_TEXTURE_SIZE, crateWoodBitmap, crateWoodPal, crateWoodPalLen, TEXTURE_FLAGS);
+
+	// Color 0 of the caustics is transparent, only the bright lines are drawn
+	paletteCaustics = NE_PaletteCreate();
+	materialCaustics = NE_MaterialCreate();
+	LoadTexture(materialCaustics, paletteCaustics, NE_PAL16, CAUSTICS_TEXTURE_SIZE, causticsBitmap, causticsPal, causticsPalLen,
+				TEXTURE_FLAGS | NE_TEXTURE_COLOR0_TRANSPARENT);
+
+	paletteSky = NE_PaletteCreate();
+	materialSky = NE_MaterialCreate();
+	LoadTexture(materialSky, paletteSky, NE_PAL256, SKY_TEXTURE_SIZE, skyBitmap, skyPal, skyPalLen, TEXTURE_FLAGS);
+	ProfilerEnd(PROFILER_SECTION_TEXTURE_LOAD);
 }
 
 /**
- * @brief Draw animated water
+ * @brief Init graphics
  *
  */
-void DrawWater()
+void InitGraphics()
 {
-	// Set water transparency
-	if (clearWater)
-		NE_PolyFormat(15, 0, NE_LIGHT_0, NE_CULL_NONE, NE_MODULATION);
-	else
-		NE_PolyFormat(25, 0, NE_LIGHT_0, NE_CULL_NONE, NE_MODULATION);
-
-	NE_PolyBegin(GL_QUAD);
-	// Do not use a texture for the wayer
-	NE_MaterialUse(NULL);
-
-	// Draw water tiles
-	glPushMatrix();
-	glScalef32(inttov16(1), WAVE_HEIGHT_INT, inttov16(1));
-	for (int x = 1; x < WATER_SIZE; x++)
+	if (waterMode == WATER_MODE_PERLIN)
 	{
-		for (int y = 1; y < WATER_SIZE; y++)
-		{
-			glPushMatrix();
-			glTranslatef32(inttov16(x * 2), inttov16(0), inttov16(y * 2));
-
-			GFX_COLOR = water[x][y].color;
-			glVertex3v16(inttov16(1), water[x][y].finalHeight, inttov16(1));
+		// Set a random water offset
+		waterXOff = rand() % 10000;
+		waterYOff = rand() % 10000;
+	}
 
-			GFX_COLOR = water[x][y - 1].color;
-			glVertex3v16(inttov16(1), water[x][y - 1].finalHeight, inttov16(-1));
+	WaterKernelsSelect(waterMode, waterStyle);
+	FlowMapBake(waterFlow, sandHeight);
+	GerstnerInit();
+	FbmInit();
+	SetWaterDetail(waterUpdateInterval, waterMeshStep);
 
-			GFX_COLOR = water[x - 1][y - 1].color;
-			glVertex3v16(inttov16(-1), water[x - 1][y - 1].finalHeight, inttov16(-1));
+	LoadGraphics();
+	SkyMapBuildTable(skyTable);
+}
 
-			GFX_COLOR = water[x - 1][y].color;
-			glVertex3v16(inttov16(-1), water[x - 1][y].finalHeight, inttov16(1));
+/**
+ * @brief Get the caustics tint of a sand point from the depth of the water above it
+ *
+ * The tint goes from the mean sand color, where the caustics blend in the sand, to white
+ *
+ * @param sandIntHeight Sand height in 20.12 fixed point
+ * @return u32 Vertex color of the caustics
+ */
+u32 CausticsColor(int sandIntHeight)
+{
+	int depth = CAUSTICS_WATER_LEVEL - sandIntHeight * SAND_HEIGHT;
+	int intensity = 0;
+	if (depth > 0 && depth < CAUSTICS_FULL_DEPTH)
+		intensity = depth * 4096 / CAUSTICS_FULL_DEPTH;
+	else if (depth >= CAUSTICS_FULL_DEPTH && depth < CAUSTICS_MAX_DEPTH)
+		intensity = (CAUSTICS_MAX_DEPTH - depth) * 4096 / (CAUSTICS_MAX_DEPTH - CAUSTICS_FULL_DEPTH);
+
+	return RGB15(29 + ((2 * intensity) >> 12), 26 + ((5 * intensity) >> 12), 21 + ((10 * intensity) >> 12));
+}
 
-			glPopMatrix(1);
+/**
+ * @brief Keep the current heights and displacements as the start of the interpolation, before a simulation step
+ *
+ */
+void SaveWaterHeights()
+{
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			water[x][y].previousHeight = water[x][y].finalHeight;
+			water[x][y].previousXOffset = water[x][y].xOffset;
+			water[x][y].previousZOffset = water[x][y].zOffset;
 		}
 	}
-	glPopMatrix(1);
-
-	NE_PolyEnd();
 }
 
 /**
- * @brief Update water points
+ * @brief Set the rendered heights and displacements between the last two simulation steps, the colors are not blended
  *
+ * @param alpha Position between the steps in 20.12 fixed point
  */
-void UpdateWater(bool initFastWater)
+void InterpolateWater(int alpha)
 {
-	needUpdateWater = !needUpdateWater;
-	float noiseXOffset = 0;
 	for (int x = 0; x < WATER_SIZE; x++)
 	{
-		if (needUpdateWater || initFastWater || !fastWater)
-			noiseXOffset = (x + waterXOff) / 10.0f;
-
 		for (int y = 0; y < WATER_SIZE; y++)
 		{
 			WaterPoint *point = &water[x][y];
-			// Update point every two frames
-			needUpdateWater = !needUpdateWater;
-			if (needUpdateWater || initFastWater)
-			{
-				// Perlin noise
-				if (!fastWater || initFastWater)
-				{
-					point->height = noise2(noiseXOffset, (y + waterYOff) / 10.0f);
-					point->intHeight = point->height * 4096;
-					point->finalHeight = point->intHeight;
-				}
-				else
-				{
-					// Use interpolation from static noise value
-					int h = Lerp(water[(x + waterGridXOff) % WATER_SIZE][y].intHeight, water[(x + 1 + waterGridXOff) % WATER_SIZE][y].intHeight, waterXOff);
-					h += Lerp(water[x][(y + waterGridYOff) % WATER_SIZE].intHeight, water[(x)][(y + 1 + waterGridYOff) % WATER_SIZE].intHeight, waterYOff);
-					h /= 2;
-					point->finalHeight = h;
-				}
-				SetWaterColor(x, y);
-			}
+			point->renderHeight = point->previousHeight + (((point->finalHeight - point->previousHeight) * alpha) >> 12);
+			point->renderXOffset = point->previousXOffset + (((point->xOffset - point->previousXOffset) * alpha) >> 12);
+			point->renderZOffset = point->previousZOffset + (((point->zOffset - point->previousZOffset) * alpha) >> 12);
 		}
 	}
 }
 
 /**
- * @brief Draw floating cube
+ * @brief Update water points
  *
  */
-void DrawCube()
+void UpdateWater(bool initFastWater)
 {
-	NE_PolyFormat(31, 0, NE_LIGHT_0, NE_CULL_BACK, NE_MODULATION);
-	NE_PolyBegin(GL_QUAD);
-	NE_MaterialUse(materialCrateWood);
-
-	// Extremely basic buoyancy simulation
-	if (!fastWater)
-		cubeYPos = water[5][8].height * WAVE_HEIGHT - 0.2f;
-	else
-		cubeYPos = water[5][8].finalHeight / 4096.0f * WAVE_HEIGHT - 0.2f;
-
-	NE_PolyColor(COLOR_WHITE); // Set next vertices color
+	// Modes that set the heights themselves
+	if (!initFastWater)
+	{
+		switch (waterMode)
+		{
+		case WATER_MODE_GERSTNER:
+			GerstnerUpdate(water, simClockStepFrames);
+			break;
+		case WATER_MODE_FBM:
+			FbmUpdate(simClockStepFrames);
+			break;
+		case WATER_MODE_PLAYBACK:
+			// The baked colors are made for the clear style
+			WaterAnimUpdate(simClockStepFrames, waterStyle == WATER_STYLE_CLEAR);
+			// A corrupt frame stops the playback, go on with the next mode
+			if (!WaterAnimIsOpen())
+				ChangeWaterMode();
+			break;
+		case WATER_MODE_PIPES:
+			UpdateWaterPipes(simClockStepFrames);
+			break;
+		default:
+			break;
+		}
+	}
 
-	//  Set cube position
-	glTranslatef32(cubeXPos * 4096, cubeYPos * 4096, cubeZPos * 4096);
+	// Points to skip before the next update
+	waterUpdatePhase = (waterUpdatePhase + 1) % waterUpdateInterval;
+
+	// The kernels of the current mode and style are selected when one of them changes
+	WaterKernelState state = {
+		.water = water,
+		.sand = sandHeight,
+		.xOff = waterXOff,
+		.yOff = waterYOff,
+		.gridXOff = waterGridXOff,
+		.gridYOff = waterGridYOff,
+		.updateInterval = waterUpdateInterval,
+		.updatePhase = waterUpdatePhase,
+		.worldX = worldX,
+		.worldY = worldY,
+		.time = waterTime,
+		.flow = waterFlow,
+	};
+	WaterKernel kernel = initFastWater ? waterKernels.init : waterKernels.step;
+	if (kernel)
+		kernel(&state);
+
+	// Nothing to interpolate from on the first update
+	if (initFastWater)
+	{
+		SaveWaterHeights();
+		InterpolateWater(0);
+	}
+}
 
-	// Draw all vertex
-	for (int vI = 0; vI < CUBE_VERTEX_COUNT; vI++)
+/**
+ * @brief Throw spray from the rising crests and from the cube, then move the spray
+ *
+ * @param frames 60 Hz frames per simulation step
+ */
+void UpdateSpray(int frames)
+{
+	int crestRise = SPRAY_RISE_HEIGHT * frames;
+	for (int x = 0; x < WATER_SIZE; x++)
 	{
-		GFX_TEX_COORD = cubeUv[vI];
-		int offset = vI * 3;
-		glVertex3v16(inttov16(cubeVert[offset]), inttov16(cubeVert[offset + 1]), inttov16(cubeVert[offset + 2]));
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			WaterPoint *point = &water[x][y];
+			int rise = point->finalHeight - point->previousHeight;
+			if (rise <= 0 || (point->finalHeight < SPRAY_CREST_HEIGHT && rise < crestRise))
+				continue;
+
+			// Same position as the water vertex
+			ParticlesSpawn(&spray, inttof32(x * 2 + 1) + point->xOffset, point->finalHeight * WAVE_HEIGHT,
+						   inttof32(y * 2 + 1) + point->zOffset, SPRAY_SPEED, SPRAY_PER_POINT);
+		}
 	}
 
-	NE_PolyEnd();
+	// The cube splashes when the water under it rises fast
+	WaterPoint *cubePoint = &water[CUBE_POINT_X][CUBE_POINT_Y];
+	if (cubePoint->finalHeight - cubePoint->previousHeight >= crestRise)
+		ParticlesSpawn(&spray, cubeXPos * 4096, cubePoint->finalHeight * WAVE_HEIGHT, cubeZPos * 4096, SPRAY_SPEED, SPRAY_PER_SPLASH);
+
+	ParticlesUpdate(&spray, frames);
 }
 
 /**
@@ -378,7 +488,20 @@ void DrawCube()
  */
 void ChangeWaterStyle()
 {
-	clearWater = !clearWater;
+	// Clear, opaque, then sky
+	switch (waterStyle)
+	{
+	case WATER_STYLE_CLEAR:
+		waterStyle = WATER_STYLE_OPAQUE;
+		break;
+	case WATER_STYLE_OPAQUE:
+		waterStyle = WATER_STYLE_SKY;
+		break;
+	default:
+		waterStyle = WATER_STYLE_CLEAR;
+		break;
+	}
+	WaterKernelsSelect(waterMode, waterStyle);
 }
 
 /**
@@ -387,38 +510,104 @@ void ChangeWaterStyle()
  */
 void ChangeWaterMode()
 {
-	fastWater = !fastWater;
+	// Remove the horizontal displacement of the waves
+	if (waterMode == WATER_MODE_GERSTNER)
+	{
+		for (int x = 0; x < WATER_SIZE; x++)
+		{
+			for (int y = 0; y < WATER_SIZE; y++)
+			{
+				water[x][y].xOffset = 0;
+				water[x][y].zOffset = 0;
+			}
+		}
+	}
+
+	waterMode = (waterMode + 1) % WATER_MODE_COUNT;
+	// Skip the playback mode if the animation file is missing
+	if (waterMode == WATER_MODE_PLAYBACK && !WaterAnimIsOpen())
+		waterMode = (waterMode + 1) % WATER_MODE_COUNT;
 	// Reset values to avoid glitches
-	if (fastWater)
+	switch (waterMode)
 	{
+	case WATER_MODE_FAST:
 		waterGridXOff = 0;
 		waterGridYOff = 0;
 		waterXOff = 0;
 		waterYOff = 0;
-	}
-	else
-	{
+		break;
+	case WATER_MODE_PERLIN:
 		// Set a random water offset
 		waterXOff = rand() % 10000;
 		waterYOff = rand() % 10000;
+		break;
+	case WATER_MODE_PIPES:
+		ResetWaterPipes();
+		break;
+	default:
+		break;
+	}
+
+	WaterKernelsSelect(waterMode, waterStyle);
+}
+
+/**
+ * @brief Move the grid over the world, the sand comes from the chunk cache
+ *
+ * @param dx Cells to move on x
+ * @param dy Cells to move on y
+ */
+void MoveWorld(int dx, int dy)
+{
+	worldX += dx;
+	worldY += dy;
+	ChunkFillSand(worldX, worldY);
+	FlowMapBake(waterFlow, sandHeight);
+	BuildSandList();
+
+	// Move the water noise with the grid so the surface stays continuous
+	if (waterMode == WATER_MODE_FAST)
+	{
+		// The offsets are the fraction between two static noise values, only the grid offsets move
+		waterGridXOff = ((waterGridXOff + dx) % WATER_SIZE + WATER_SIZE) % WATER_SIZE;
+		waterGridYOff = ((waterGridYOff + dy) % WATER_SIZE + WATER_SIZE) % WATER_SIZE;
 	}
+	else if (waterMode == WATER_MODE_PERLIN)
+	{
+		waterXOff += dx;
+		waterYOff += dy;
+	}
+	FbmMove(dx, dy);
+	GerstnerMove(dx, dy);
+	// The shallow water does not follow the grid, it starts again over the new sand
+	if (waterMode == WATER_MODE_PIPES)
+		ResetWaterPipes();
 }
 
 /**
- * @brief Update scene (camera rotation and water offset)
+ * @brief Update scene (camera rotation and water offset) for one simulation step
  *
  */
 void UpdateScene()
 {
+	int frames = simClockStepFrames;
+
 	// Rotate the camera
-	angle += 0.003f;
-	SetCameraPosition();
+	previousAngle = angle;
+	angle = (angle + CAMERA_ROTATION_SPEED * frames) & (TRIG_ANGLE_FULL - 1);
+
+	// Scroll the caustics, wrapped on the texture size
+	causticsU = (causticsU + CAUSTICS_SCROLL_U * frames) & CAUSTICS_UV_MASK;
+	causticsV = (causticsV + CAUSTICS_SCROLL_V * frames) & CAUSTICS_UV_MASK;
+
+	// The simplex water evolves instead of scrolling, the flow water follows its currents
+	waterTime += WATER_TIME_SPEED * frames;
 
 	// Update water offset
-	waterXOff += 0.05f;
-	waterYOff += 0.05f;
+	waterXOff += 0.05f * frames;
+	waterYOff += 0.05f * frames;
 
-	if (fastWater)
+	if (waterMode == WATER_MODE_FAST)
 	{
 		// Reset offset for fast water simulation
 		if (waterXOff >= 1)
@@ -436,45 +625,107 @@ void UpdateScene()
 }
 
 /**
- * @brief Render scene
+ * @brief Render scene, on the top screen
  *
  */
 void Draw3DScene(void)
 {
-	// Set camera for drawing
+	ProfilerBegin(PROFILER_SECTION_TOP_SCREEN);
+
+	// Run the simulation steps for the time elapsed since the last frame
+	ProfilerBegin(PROFILER_SECTION_UPDATE_WATER);
+	int steps = SimClockAdvance();
+	for (int i = 0; i < steps; i++)
+	{
+		SaveWaterHeights();
+		UpdateScene();
+		UpdateWater(false);
+		UpdateSpray(simClockStepFrames);
+	}
+	InterpolateWater(simClockAlpha);
+	ProfilerEnd(PROFILER_SECTION_UPDATE_WATER);
+	ProfilerAddCount(PROFILER_COUNTER_SIMULATION_STEPS, steps);
+
+	// Set camera for drawing, between the last two steps
+	int angleDelta = (angle - previousAngle) & (TRIG_ANGLE_FULL - 1);
+	int cameraAngle = previousAngle + ((angleDelta * simClockAlpha) >> 12);
+	SetCameraPosition(cameraAngle);
 	NE_CameraUse(Camera);
 
-	// Update scene
-	UpdateScene();
+	ProfilerBegin(PROFILER_SECTION_DRAW);
 
-	// Update water points
-	UpdateWater(false);
+	// Extremely basic buoyancy simulation
+	cubeYPos = water[CUBE_POINT_X][CUBE_POINT_Y].renderHeight / 4096.0f * WAVE_HEIGHT - 0.2f;
+
+	// Sky texture coordinates from the slopes of the interpolated surface
+	if (waterStyle == WATER_STYLE_SKY)
+		SkyMapUpdate(water, skyTable, cameraAngle);
+
+	// The camera looks along (sin, cos), the spray quads are built along its right vector
+	if (spray.count > 0)
+		ParticlesBuildList(&spray, sprayList, TrigCosLerp(cameraAngle), -TrigSinLerp(cameraAngle));
+
+	scene = (SceneDrawState){
+		.water = water,
+		.sand = sandHeight,
+		.meshIndices = meshIndices,
+		.meshIndexCount = meshIndexCount,
+		.worldX = worldX,
+		.worldY = worldY,
+		.causticsU = causticsU,
+		.causticsV = causticsV,
+		.style = waterStyle,
+		.cubeX = cubeXPos * 4096,
+		.cubeY = cubeYPos * 4096,
+		.cubeZ = cubeZPos * 4096,
+		.sprayList = spray.count > 0 ? sprayList : NULL,
+		.sandList = sandList,
+		.sandMaterial = materialTileSand,
+		.causticsMaterial = materialCaustics,
+		.cubeMaterial = materialCrateWood,
+		.skyMaterial = materialSky,
+	};
 
 	// Draw sand
-	DrawSand();
+	DrawSand(&scene);
+
+	// Draw caustics over the sand
+	DrawCaustics(&scene);
 
 	// Draw water
-	DrawWater();
+	DrawWater(&scene);
+
+	// Draw spray over the water
+	DrawSpray(&scene);
 
 	// Draw cube
-	DrawCube();
-
-	// Init text drawing
-	NE_2DViewInit();
-
-	// Print performance text
-	char perfText[21];
-	sprintf(perfText, "CPU: %d%%, poly: %d\n", NE_GetCPUPercent(), NE_GetPolygonCount());
-	NE_TextPrint(0,		   // Font slot
-				 1, 1,	   // Coordinates x(column), y(row)
-				 NE_White, // Color
-				 perfText);
-
-	// Print player inputs
-	char keyText[46];
-	sprintf(keyText, "A: Change water style\n B:Change water quality");
-	NE_TextPrint(0,		   // Font slot
-				 1, 2,	   // Coordinates x(column), y(row)
-				 NE_White, // Color
-				 keyText);
+	DrawCube(&scene);
+
+	ProfilerEnd(PROFILER_SECTION_DRAW);
+	ProfilerEnd(PROFILER_SECTION_TOP_SCREEN);
+}
+
+/**
+ * @brief Render the map of the grid seen from above, on the bottom screen in dual screen mode
+ *
+ * It runs on the frames between two Draw3DScene calls and draws the scene they set,
+ * so the simulation steps, the interpolation and the sand list are not done twice
+ *
+ */
+void DrawMapScene(void)
+{
+	// The top screen has not set a scene since the engine started
+	if (!scene.sandList)
+		return;
+
+	ProfilerBegin(PROFILER_SECTION_BOTTOM_SCREEN);
+	NE_CameraUse(mapCamera);
+
+	DrawSand(&scene);
+	DrawCaustics(&scene);
+	DrawWater(&scene);
+	// The spray quads face the camera of the top screen, they are edge on from above
+	DrawCube(&scene);
+
+	ProfilerEnd(PROFILER_SECTION_BOTTOM_SCREEN);
 }
\ No newline at end of file
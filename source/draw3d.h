@@ -2,30 +2,27 @@
 #define DRAW3D_H_
 
 #include <NEMain.h>
+#include "water.h"
 
-typedef struct
-{
-    float height;
-    int intHeight;
-    int finalHeight;
-    u32 color;
-} WaterPoint;
-
-typedef struct
-{
-    float height;
-    int intHeight;
-} SandPoint;
-
-#define WATER_SIZE 14 // EVEN NUMBER ONLY
-
-extern WaterPoint water[WATER_SIZE][WATER_SIZE];
-extern SandPoint sandHeight[WATER_SIZE][WATER_SIZE];
+extern WaterPoint (*water)[WATER_SIZE];
+extern SandPoint (*sandHeight)[WATER_SIZE];
+extern WaterMode waterMode;
+extern WaterStyle waterStyle;
+extern int waterUpdateInterval;
+extern int waterMeshStep;
 
+void AllocateWaterGrids();
+u32 CausticsColor(int sandIntHeight);
+void SetWaterDetail(int updateInterval, int meshStep);
+void LoadGraphics();
 void InitGraphics();
 void Draw3DScene(void);
+void DrawMapScene(void);
 void UpdateWater(bool initFastWater);
+void SaveWaterHeights();
+void InterpolateWater(int alpha);
 void ChangeWaterMode();
+void MoveWorld(int dx, int dy);
 void ChangeWaterStyle();
 
 #endif // DRAW3D_H_
\ No newline at end of file
@@ -0,0 +1,271 @@
+#include "fbm.h"
+#include "draw3d.h"
+#include <string.h>
+#include "noise.h"
+#include "profiler.h"
+#include "arena.h"
+#include "simclock.h"
+
+// All noise octaves, the first ones are the lowest frequencies
+FbmOctave fbmOctaves[FBM_MAX_OCTAVES];
+// Number of octaves summed in the water height
+int fbmOctaveCount = FBM_MAX_OCTAVES;
+// Octave that gets the budget first, rotated every frame
+int fbmFirstOctave = 0;
+
+/**
+ * @brief Sample the noise of an octave at a cell of a snapshot
+ *
+ * @param octave
+ * @param snapshot
+ * @param cell Cell index, in the order of the water grid
+ * @return int16_t
+ */
+static inline int16_t FbmSample(const FbmOctave *octave, const FbmSnapshot *snapshot, int cell)
+{
+	int x = cell / WATER_SIZE;
+	int y = cell - x * WATER_SIZE;
+	return noise2((x + snapshot->xOff) * octave->frequency, (y + snapshot->yOff) * octave->frequency) * 4096;
+}
+
+/**
+ * @brief Set the offset of a snapshot and fill every cell
+ *
+ * @param octave
+ * @param snapshot
+ * @param xOff Noise offset of the snapshot
+ * @param yOff
+ */
+void FbmFillSnapshot(const FbmOctave *octave, FbmSnapshot *snapshot, float xOff, float yOff)
+{
+	snapshot->xOff = xOff;
+	snapshot->yOff = yOff;
+	for (int cell = 0; cell < FBM_CELL_COUNT; cell++)
+		snapshot->values[cell] = FbmSample(octave, snapshot, cell);
+}
+
+/**
+ * @brief Set an octave and fill its snapshots
+ *
+ * @param index
+ * @param frequency Noise coordinates per grid cell
+ * @param amplitude Weight in 20.12 fixed point
+ * @param scroll Noise offset added every 60 Hz frame on both axes
+ * @param updatePeriod Simulation steps to refresh every cell, and between two snapshots
+ */
+void FbmSetOctave(int index, float frequency, int amplitude, float scroll, int updatePeriod)
+{
+	FbmOctave *octave = &fbmOctaves[index];
+	octave->frequency = frequency;
+	octave->amplitude = amplitude;
+	octave->scrollX = scroll;
+	octave->scrollY = scroll;
+	octave->updatePeriod = updatePeriod;
+	if (!octave->from.values)
+	{
+		int16_t *values = ArenaAlloc(ARENA_FBM, FBM_SNAPSHOTS * FBM_CELL_COUNT * sizeof(int16_t));
+		sassert(values, "Arena full: fBm octaves");
+		octave->from.values = values;
+		octave->to.values = values + FBM_CELL_COUNT;
+		octave->refresh.values = values + 2 * FBM_CELL_COUNT;
+	}
+	// Random start to not get the same pattern on every octave
+	float xOff = rand() % 10000;
+	float yOff = rand() % 10000;
+	float scrollPeriod = scroll * updatePeriod * simClockStepFrames;
+	FbmFillSnapshot(octave, &octave->from, xOff, yOff);
+	FbmFillSnapshot(octave, &octave->to, xOff + scrollPeriod, yOff + scrollPeriod);
+	octave->refresh.xOff = xOff + 2 * scrollPeriod;
+	octave->refresh.yOff = yOff + 2 * scrollPeriod;
+	octave->cursor = 0;
+	octave->frame = 0;
+}
+
+/**
+ * @brief Set the default octaves
+ *
+ */
+void FbmInit()
+{
+	// Higher frequencies are refreshed more often, the default periods need 94 samples per frame, under the budget
+	// Amplitudes sum to 1 to stay in the 0 to 1 range of noise2 that the color kernels expect
+	FbmSetOctave(0, 1 / 10.0f, floattof32(0.55), 0.05f, 32);
+	FbmSetOctave(1, 1 / 5.0f, floattof32(0.25), 0.08f, 16);
+	FbmSetOctave(2, 1 / 2.5f, floattof32(0.13), 0.12f, 8);
+	FbmSetOctave(3, 1 / 1.25f, floattof32(0.07), 0.2f, 4);
+	fbmOctaveCount = FBM_MAX_OCTAVES;
+}
+
+/**
+ * @brief Set how many octaves are updated and summed
+ *
+ * @param count From 1 to FBM_MAX_OCTAVES
+ */
+void FbmSetOctaveCount(int count)
+{
+	if (count < 1)
+		count = 1;
+	else if (count > FBM_MAX_OCTAVES)
+		count = FBM_MAX_OCTAVES;
+	fbmOctaveCount = count;
+}
+
+/**
+ * @brief Refresh the next cells of the refreshed snapshot, every cell of a snapshot is sampled at the same offset
+ *
+ * @param octave
+ * @param count Number of cells to refresh
+ */
+void FbmRefreshSlice(FbmOctave *octave, int count)
+{
+	int cursor = octave->cursor;
+	int end = cursor + count;
+	if (end > FBM_CELL_COUNT)
+		end = FBM_CELL_COUNT;
+	for (; cursor < end; cursor++)
+		octave->refresh.values[cursor] = FbmSample(octave, &octave->refresh, cursor);
+	octave->cursor = cursor;
+}
+
+/**
+ * @brief Move the blend to the next snapshot when a period has passed and the refreshed snapshot is complete
+ *
+ * @param octave
+ * @param frames 60 Hz frames per simulation step
+ */
+void FbmNextSnapshot(FbmOctave *octave, int frames)
+{
+	if (octave->frame < octave->updatePeriod)
+		return;
+
+	// Hold the newest snapshot until the refresh catches up, when the budget is short
+	if (octave->cursor < FBM_CELL_COUNT)
+	{
+		octave->frame = octave->updatePeriod;
+		return;
+	}
+
+	FbmSnapshot from = octave->from;
+	octave->from = octave->to;
+	octave->to = octave->refresh;
+	octave->refresh = from;
+	octave->cursor = 0;
+	octave->frame -= octave->updatePeriod;
+	if (octave->frame > octave->updatePeriod)
+		octave->frame = octave->updatePeriod;
+	// The new refreshed snapshot is a period after the newest blended one
+	octave->refresh.xOff = octave->to.xOff + octave->scrollX * octave->updatePeriod * frames;
+	octave->refresh.yOff = octave->to.yOff + octave->scrollY * octave->updatePeriod * frames;
+}
+
+/**
+ * @brief Refresh a slice of each octave within the step budget, and sum the octaves in the water grid
+ *
+ * Each octave blends two complete snapshots taken a period apart, so the cells refreshed at different frames
+ * never show a seam
+ *
+ * @param frames Number of 60 Hz frames to scroll
+ */
+void FbmUpdate(int frames)
+{
+	int budget = FBM_SAMPLE_BUDGET;
+	if (fbmFirstOctave >= fbmOctaveCount)
+		fbmFirstOctave = 0;
+
+	for (int i = 0; i < fbmOctaveCount; i++)
+	{
+		FbmOctave *octave = &fbmOctaves[(fbmFirstOctave + i) % fbmOctaveCount];
+		octave->frame++;
+
+		// Cells needed to refresh the whole snapshot in its period
+		int slice = (FBM_CELL_COUNT + octave->updatePeriod - 1) / octave->updatePeriod;
+		if (slice > FBM_CELL_COUNT - octave->cursor)
+			slice = FBM_CELL_COUNT - octave->cursor;
+		if (slice > budget)
+			slice = budget;
+		FbmRefreshSlice(octave, slice);
+		budget -= slice;
+		FbmNextSnapshot(octave, frames);
+	}
+	// Give the budget to another octave first next frame, so no octave starves when the budget is short
+	fbmFirstOctave++;
+	ProfilerAddCount(PROFILER_COUNTER_NOISE_SAMPLES, FBM_SAMPLE_BUDGET - budget);
+
+	// Position of every octave between its two snapshots in 20.12 fixed point
+	int blends[FBM_MAX_OCTAVES];
+	for (int i = 0; i < fbmOctaveCount; i++)
+		blends[i] = (fbmOctaves[i].frame << 12) / fbmOctaves[i].updatePeriod;
+
+	// Sum the cached octaves
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			int cell = x * WATER_SIZE + y;
+			int height = 0;
+			for (int i = 0; i < fbmOctaveCount; i++)
+			{
+				const FbmOctave *octave = &fbmOctaves[i];
+				int from = octave->from.values[cell];
+				int value = from + (((octave->to.values[cell] - from) * blends[i]) >> 12);
+				height += (value * octave->amplitude) >> 12;
+			}
+			water[x][y].finalHeight = height;
+		}
+	}
+}
+
+/**
+ * @brief Shift a snapshot when the grid moves, only the cells that come into the grid are sampled
+ *
+ * @param octave
+ * @param snapshot
+ * @param dx Cells moved on x
+ * @param dy Cells moved on y
+ * @param filled Cells already sampled, from the first one, FBM_CELL_COUNT for a complete snapshot
+ * @return int Number of noise samples
+ */
+static int FbmMoveSnapshot(const FbmOctave *octave, FbmSnapshot *snapshot, int dx, int dy, int filled)
+{
+	int16_t moved[FBM_CELL_COUNT];
+	snapshot->xOff += dx;
+	snapshot->yOff += dy;
+
+	int samples = 0;
+	for (int cell = 0; cell < filled; cell++)
+	{
+		int x = cell / WATER_SIZE + dx;
+		int y = cell % WATER_SIZE + dy;
+		int source = x * WATER_SIZE + y;
+		if (x >= 0 && x < WATER_SIZE && y >= 0 && y < WATER_SIZE && source < filled)
+		{
+			moved[cell] = snapshot->values[source];
+		}
+		else
+		{
+			moved[cell] = FbmSample(octave, snapshot, cell);
+			samples++;
+		}
+	}
+	memcpy(snapshot->values, moved, filled * sizeof(int16_t));
+	return samples;
+}
+
+/**
+ * @brief Shift the octaves when the grid moves over the world, so the surface stays continuous
+ *
+ * @param dx Cells moved on x
+ * @param dy Cells moved on y
+ */
+void FbmMove(int dx, int dy)
+{
+	int samples = 0;
+	for (int i = 0; i < FBM_MAX_OCTAVES; i++)
+	{
+		FbmOctave *octave = &fbmOctaves[i];
+		samples += FbmMoveSnapshot(octave, &octave->from, dx, dy, FBM_CELL_COUNT);
+		samples += FbmMoveSnapshot(octave, &octave->to, dx, dy, FBM_CELL_COUNT);
+		samples += FbmMoveSnapshot(octave, &octave->refresh, dx, dy, octave->cursor);
+	}
+	ProfilerAddCount(PROFILER_COUNTER_NOISE_SAMPLES, samples);
+}
@@ -0,0 +1,46 @@
+#ifndef FBM_H_ /* Include guard */
+#define FBM_H_
+
+// Shared by the game and the host tools, only uses the standard headers
+#include <stdint.h>
+#include "water.h"
+
+#define FBM_MAX_OCTAVES 4
+// Maximum noise2 calls per frame for all octaves together
+#define FBM_SAMPLE_BUDGET (WATER_SIZE * WATER_SIZE / 2)
+#define FBM_CELL_COUNT (WATER_SIZE * WATER_SIZE)
+// Cached grids of an octave: the two blended ones, and the one being refreshed
+#define FBM_SNAPSHOTS 3
+
+// Cached noise values of an octave, all sampled at the same offset
+typedef struct
+{
+    float xOff;      // Noise offset on x
+    float yOff;      // Noise offset on y
+    int16_t *values; // Noise values in 20.12 fixed point, FBM_CELL_COUNT values
+} FbmSnapshot;
+
+typedef struct
+{
+    float frequency;  // Noise coordinates per grid cell
+    int amplitude;    // Weight of the octave in 20.12 fixed point
+    float scrollX;    // Noise offset added every 60 Hz frame on x
+    float scrollY;    // Noise offset added every 60 Hz frame on y
+    int updatePeriod; // Simulation steps to refresh every cell of the octave, and between two snapshots
+
+    int cursor;          // Next cell of the refreshed snapshot, FBM_CELL_COUNT when it is complete
+    int frame;           // Simulation steps since the oldest blended snapshot, up to updatePeriod
+    FbmSnapshot from;    // Oldest blended snapshot
+    FbmSnapshot to;      // Newest blended snapshot, one period later
+    FbmSnapshot refresh; // Snapshot refreshed in slices, one period after to
+} FbmOctave;
+
+extern FbmOctave fbmOctaves[FBM_MAX_OCTAVES];
+extern int fbmOctaveCount;
+
+void FbmInit();
+void FbmSetOctaveCount(int count);
+void FbmUpdate(int frames);
+void FbmMove(int dx, int dy);
+
+#endif // FBM_H_
@@ -0,0 +1,52 @@
+#include "flowmap.h"
+
+// Current of the open water, along the diagonal like the offsets of the other modes
+#define FLOW_BASE_X 40
+#define FLOW_BASE_Y 40
+// Flow per sand height difference over two points, in 1/256
+#define FLOW_TURN_GAIN 6
+#define FLOW_PUSH_GAIN 3
+#define FLOW_MAX 127
+
+/**
+ * @brief Clamp a flow component to a signed byte
+ *
+ * @param value
+ * @return int
+ */
+static inline int FlowClamp(int value)
+{
+	if (value > FLOW_MAX)
+		return FLOW_MAX;
+	if (value < -FLOW_MAX)
+		return -FLOW_MAX;
+	return value;
+}
+
+/**
+ * @brief Bake the flow of every point from the sand heights, called when the sand changes
+ *
+ * The current turns along the contour lines of the sand, so it goes around the dunes and makes eddies behind them,
+ * and is pushed down the slopes, away from the shallow water
+ *
+ * @param flow WATER_SIZE * WATER_SIZE vectors, in the order of the water grid
+ * @param sand
+ */
+void FlowMapBake(FlowVector *flow, SandPoint (*sand)[WATER_SIZE])
+{
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		const SandPoint *previousRow = sand[x > 0 ? x - 1 : x];
+		const SandPoint *nextRow = sand[x < WATER_SIZE - 1 ? x + 1 : x];
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			int gradientX = nextRow[y].intHeight - previousRow[y].intHeight;
+			int gradientY = sand[x][y < WATER_SIZE - 1 ? y + 1 : y].intHeight - sand[x][y > 0 ? y - 1 : y].intHeight;
+
+			// Perpendicular to the gradient, minus the gradient
+			int flowX = FLOW_BASE_X + ((-gradientY * FLOW_TURN_GAIN - gradientX * FLOW_PUSH_GAIN) >> 8);
+			int flowY = FLOW_BASE_Y + ((gradientX * FLOW_TURN_GAIN - gradientY * FLOW_PUSH_GAIN) >> 8);
+			flow[x * WATER_SIZE + y] = FLOW_PACK(FlowClamp(flowX), FlowClamp(flowY));
+		}
+	}
+}
@@ -0,0 +1,16 @@
+#ifndef FLOWMAP_H_ /* Include guard */
+#define FLOWMAP_H_
+
+// Shared by the game and the host tools, only uses the standard headers
+#include "water.h"
+
+// Flow vector of a point, signed 8 bit x in the low byte and y in the high byte
+typedef uint16_t FlowVector;
+
+#define FLOW_PACK(x, y) ((FlowVector)(((x) & 0xFF) | (((y) & 0xFF) << 8)))
+#define FLOW_X(vector) ((int8_t)((vector) & 0xFF))
+#define FLOW_Y(vector) ((int8_t)((vector) >> 8))
+
+void FlowMapBake(FlowVector *flow, SandPoint (*sand)[WATER_SIZE]);
+
+#endif // FLOWMAP_H_
@@ -0,0 +1,132 @@
+#include "gerstner.h"
+#include "trig.h"
+
+// 20.12 fixed point constants of the wave set
+#define GERSTNER_FIXED(n) ((int)((n) * 4096))
+
+// All waves summed for the water surface
+GerstnerWave gerstnerWaves[GERSTNER_MAX_WAVES];
+int gerstnerWaveCount = 0;
+// Phase of every wave at the grid origin
+int gerstnerPhase[GERSTNER_MAX_WAVES];
+
+/**
+ * @brief Set the default wave set
+ *
+ */
+void GerstnerInit()
+{
+	gerstnerWaveCount = 0;
+	// Amplitudes sum to less than GERSTNER_BASE_HEIGHT to stay in the 0 to 1 range of noise2
+	// Long swell
+	GerstnerSetWave(0, GERSTNER_FIXED(0.25), GERSTNER_FIXED(9), 600, TRIG_ANGLE_FULL / 12, GERSTNER_FIXED(1.0));
+	// Cross waves
+	GerstnerSetWave(1, GERSTNER_FIXED(0.15), GERSTNER_FIXED(5), 900, TRIG_ANGLE_FULL * 5 / 18, GERSTNER_FIXED(0.8));
+	// Small ripples
+	GerstnerSetWave(2, GERSTNER_FIXED(0.08), GERSTNER_FIXED(3), 1300, TRIG_ANGLE_FULL * 5 / 9, GERSTNER_FIXED(0.6));
+}
+
+/**
+ * @brief Set a wave and precompute its per cell increments
+ *
+ * @param index Wave index, the wave count grows to include it
+ * @param amplitude Height in 20.12 fixed point
+ * @param wavelength Length in grid cells, 20.12 fixed point
+ * @param speed Phase speed in binary angle units per 60 Hz frame
+ * @param direction Travel direction in binary angle units
+ * @param steepness Crest sharpness in 20.12 fixed point
+ */
+void GerstnerSetWave(int index, int amplitude, int wavelength, int speed, int direction, int steepness)
+{
+	if (index < 0 || index >= GERSTNER_MAX_WAVES || wavelength <= 0)
+		return;
+
+	GerstnerWave *wave = &gerstnerWaves[index];
+	wave->amplitude = amplitude;
+	wave->wavelength = wavelength;
+	wave->speed = speed;
+	wave->direction = direction;
+	wave->steepness = steepness;
+
+	int dirX = TrigCosLerp(direction);
+	int dirY = TrigSinLerp(direction);
+
+	// A full turn of phase every wavelength, split on both grid axes
+	wave->phaseStepX = (int64_t)TRIG_ANGLE_FULL * dirX / wavelength;
+	wave->phaseStepY = (int64_t)TRIG_ANGLE_FULL * dirY / wavelength;
+
+	// Points move toward the crests, steepness * amplitude along the wave direction
+	int displacement = (steepness * amplitude) >> 12;
+	wave->displacementX = (displacement * dirX) >> 12;
+	wave->displacementZ = (displacement * dirY) >> 12;
+
+	if (index >= gerstnerWaveCount)
+		gerstnerWaveCount = index + 1;
+}
+
+/**
+ * @brief Advance the waves and write heights and horizontal displacement in the water grid
+ *
+ * @param grid Water grid
+ * @param frames Number of 60 Hz frames to advance
+ */
+void GerstnerUpdate(WaterPoint (*grid)[WATER_SIZE], int frames)
+{
+	for (int w = 0; w < gerstnerWaveCount; w++)
+		gerstnerPhase[w] = (gerstnerPhase[w] + gerstnerWaves[w].speed * frames) & (TRIG_ANGLE_FULL - 1);
+
+	// Reset the grid to the rest level before summing every wave
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			WaterPoint *point = &grid[x][y];
+			point->finalHeight = GERSTNER_BASE_HEIGHT;
+			point->xOffset = 0;
+			point->zOffset = 0;
+		}
+	}
+
+	for (int w = 0; w < gerstnerWaveCount; w++)
+	{
+		GerstnerWave *wave = &gerstnerWaves[w];
+		int amplitude = wave->amplitude;
+		int displacementX = wave->displacementX;
+		int displacementZ = wave->displacementZ;
+		int stepY = wave->phaseStepY;
+		// Phase at the start of the row
+		int rowPhase = gerstnerPhase[w];
+
+		for (int x = 0; x < WATER_SIZE; x++)
+		{
+			int phase = rowPhase;
+			WaterPoint *point = grid[x];
+			for (int y = 0; y < WATER_SIZE; y++)
+			{
+				int sine = TrigSin(phase);
+				int cosine = TrigCos(phase);
+				point->finalHeight += (amplitude * sine) >> 12;
+				point->xOffset += (displacementX * cosine) >> 12;
+				point->zOffset += (displacementZ * cosine) >> 12;
+				point++;
+				phase += stepY;
+			}
+			rowPhase += wave->phaseStepX;
+		}
+	}
+}
+
+/**
+ * @brief Shift the waves when the grid moves over the world
+ *
+ * @param dx Cells moved on x
+ * @param dy Cells moved on y
+ */
+void GerstnerMove(int dx, int dy)
+{
+	for (int w = 0; w < gerstnerWaveCount; w++)
+	{
+		GerstnerWave *wave = &gerstnerWaves[w];
+		gerstnerPhase[w] = (gerstnerPhase[w] + wave->phaseStepX * dx + wave->phaseStepY * dy) & (TRIG_ANGLE_FULL - 1);
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef GERSTNER_H_ /* Include guard */
+#define GERSTNER_H_
+
+// Shared by the game and the host benchmark, only uses the standard headers and the trig tables
+#include "water.h"
+
+#define GERSTNER_MAX_WAVES 4
+// Rest level of the water, the middle of the noise2 range used by the other modes
+#define GERSTNER_BASE_HEIGHT 2048
+
+typedef struct
+{
+    int amplitude;  // Height of the wave in 20.12 fixed point (4096 = WAVE_HEIGHT)
+    int wavelength; // Length of the wave in grid cells, 20.12 fixed point
+    int speed;      // Phase speed in binary angle units per 60 Hz frame
+    int direction;  // Travel direction in binary angle units
+    int steepness;  // Crest sharpness in 20.12 fixed point (0 = sine wave, 4096 = sharpest)
+
+    // Values precomputed by GerstnerSetWave
+    int phaseStepX;    // Phase increment between two cells on x
+    int phaseStepY;    // Phase increment between two cells on y
+    int displacementX; // Horizontal displacement amplitude on x (v16)
+    int displacementZ; // Horizontal displacement amplitude on z (v16)
+} GerstnerWave;
+
+extern GerstnerWave gerstnerWaves[GERSTNER_MAX_WAVES];
+extern int gerstnerWaveCount;
+
+void GerstnerInit();
+void GerstnerSetWave(int index, int amplitude, int wavelength, int speed, int direction, int steepness);
+void GerstnerUpdate(WaterPoint (*grid)[WATER_SIZE], int frames);
+void GerstnerMove(int dx, int dy);
+
+#endif // GERSTNER_H_
@@ -0,0 +1,111 @@
+#include "governor.h"
+#include <stddef.h>
+
+// Quality levels from the best to the cheapest
+const GovernorLevel governorLevels[] = {
+	{1, 4, 1, 60},
+	{2, 4, 1, 60}, // Default quality
+	{3, 3, 1, 60},
+	{4, 2, 1, 60},
+	{2, 2, 2, 30},
+	{3, 1, 2, 30},
+};
+#define GOVERNOR_LEVEL_COUNT (int)(sizeof(governorLevels) / sizeof(governorLevels[0]))
+#define GOVERNOR_DEFAULT_LEVEL 1
+const int governorLevelCount = GOVERNOR_LEVEL_COUNT;
+
+int governorLevel = GOVERNOR_DEFAULT_LEVEL;
+bool governorEnabled = true;
+// Frames in a row over or under the thresholds
+int governorHeavyFrames = 0;
+int governorLightFrames = 0;
+uint32_t governorFrame = 0;
+// Sets the quality of the game
+GovernorApply governorApply = NULL;
+
+// Last level changes, the oldest are overwritten
+GovernorLogEntry governorLog[GOVERNOR_LOG_SIZE];
+int governorLogCount = 0;
+
+/**
+ * @brief Apply the default quality level
+ *
+ * @param apply Called with the settings of every new level
+ */
+void GovernorInit(GovernorApply apply)
+{
+	governorApply = apply;
+	governorHeavyFrames = 0;
+	governorLightFrames = 0;
+	governorFrame = 0;
+	governorLogCount = 0;
+	GovernorSetLevel(GOVERNOR_DEFAULT_LEVEL);
+}
+
+/**
+ * @brief Apply a quality level to the game
+ *
+ * @param level From 0 (best) to GOVERNOR_LEVEL_COUNT - 1 (cheapest)
+ */
+void GovernorSetLevel(int level)
+{
+	if (level < 0)
+		level = 0;
+	else if (level >= GOVERNOR_LEVEL_COUNT)
+		level = GOVERNOR_LEVEL_COUNT - 1;
+
+	governorLevel = level;
+	governorApply(&governorLevels[level]);
+}
+
+/**
+ * @brief Feed the governor with the cost of the last frame and change the quality level if needed
+ *
+ * @param frameTicks CPU time of the frame in timer ticks
+ * @param polygons Polygon count of the frame
+ * @return true if the quality level changed
+ */
+bool GovernorUpdate(uint32_t frameTicks, int polygons)
+{
+	governorFrame++;
+	if (!governorEnabled)
+		return false;
+
+	if (frameTicks > GOVERNOR_HIGH_TICKS || polygons > GOVERNOR_POLYGON_LIMIT)
+	{
+		governorHeavyFrames++;
+		governorLightFrames = 0;
+	}
+	else if (frameTicks < GOVERNOR_LOW_TICKS)
+	{
+		governorLightFrames++;
+		governorHeavyFrames = 0;
+	}
+	else
+	{
+		// Inside the hysteresis band, keep the current level
+		governorHeavyFrames = 0;
+		governorLightFrames = 0;
+	}
+
+	int newLevel = governorLevel;
+	if (governorHeavyFrames >= GOVERNOR_DOWN_FRAMES && governorLevel < GOVERNOR_LEVEL_COUNT - 1)
+		newLevel++;
+	else if (governorLightFrames >= GOVERNOR_UP_FRAMES && governorLevel > 0)
+		newLevel--;
+
+	if (newLevel == governorLevel)
+		return false;
+
+	governorHeavyFrames = 0;
+	governorLightFrames = 0;
+	GovernorSetLevel(newLevel);
+
+	GovernorLogEntry *entry = &governorLog[governorLogCount % GOVERNOR_LOG_SIZE];
+	entry->frame = governorFrame;
+	entry->frameTicks = frameTicks;
+	entry->polygons = polygons;
+	entry->level = newLevel;
+	governorLogCount++;
+	return true;
+}
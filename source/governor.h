@@ -0,0 +1,57 @@
+#ifndef GOVERNOR_H_ /* Include guard */
+#define GOVERNOR_H_
+
+// Shared by the game and the host replay tool, only uses the standard headers and gx.h
+#include <stdbool.h>
+#include <stdint.h>
+#include "gx.h"
+
+// Timer ticks per second, BUS_CLOCK of libnds
+#define GOVERNOR_CLOCK_HZ 33513982
+// Frame time of a 60 fps frame in timer ticks
+#define GOVERNOR_FRAME_TICKS (GOVERNOR_CLOCK_HZ / 60)
+// Above this frame time, the frame is overloaded
+#define GOVERNOR_HIGH_TICKS (GOVERNOR_FRAME_TICKS * 85 / 100)
+// Under this frame time, there is room for a better quality
+#define GOVERNOR_LOW_TICKS (GOVERNOR_FRAME_TICKS * 55 / 100)
+// Above this polygon count, the frame is overloaded: a quarter of the polygon RAM is kept free so the
+// polygons of a heavier scene are not dropped. The scene peaks at 642 polygons at full quality with a
+// full spray pool (tools/gx), so this only guards against a scene that grows
+#define GOVERNOR_POLYGON_LIMIT (GX_POLYGON_RAM_LIMIT * 3 / 4)
+// Overloaded frames in a row before lowering the quality
+#define GOVERNOR_DOWN_FRAMES 3
+// Light frames in a row before raising the quality
+#define GOVERNOR_UP_FRAMES 120
+#define GOVERNOR_LOG_SIZE 16
+
+typedef struct
+{
+    int updateInterval; // Simulation steps between two updates of a water point
+    int octaveCount;    // Number of fBm octaves
+    int meshStep;       // Points between two mesh vertices
+    int stepHz;         // Simulation steps per second
+} GovernorLevel;
+
+typedef struct
+{
+    uint32_t frame;      // Frame of the change
+    uint32_t frameTicks; // Frame time that triggered the change
+    int polygons;   // Polygon count that triggered the change
+    int level;      // New quality level
+} GovernorLogEntry;
+
+// Applies the settings of a quality level to the game
+typedef void (*GovernorApply)(const GovernorLevel *settings);
+
+extern int governorLevel;
+extern bool governorEnabled;
+extern GovernorLogEntry governorLog[GOVERNOR_LOG_SIZE];
+extern int governorLogCount;
+extern const GovernorLevel governorLevels[];
+extern const int governorLevelCount;
+
+void GovernorInit(GovernorApply apply);
+void GovernorSetLevel(int level);
+bool GovernorUpdate(uint32_t frameTicks, int polygons);
+
+#endif // GOVERNOR_H_
@@ -0,0 +1,281 @@
+#include "gx.h"
+
+#ifndef ARM9
+#include <stdlib.h>
+#include <string.h>
+
+GxRecording gxRecording;
+GxCounters gxCounters;
+
+// Primitive type of the last begin, -1 outside of a begin
+int gxPrimitive = -1;
+// Vertices sent since the last begin
+int gxPrimitiveVertices = 0;
+
+/**
+ * @brief Start a new recording, the buffer of the previous one is kept
+ *
+ */
+void GxRecordStart()
+{
+	gxRecording.size = 0;
+	memset(&gxCounters, 0, sizeof(GxCounters));
+	gxPrimitive = -1;
+	gxPrimitiveVertices = 0;
+}
+
+/**
+ * @brief Free the recording buffer
+ *
+ */
+void GxRecordFree()
+{
+	free(gxRecording.words);
+	memset(&gxRecording, 0, sizeof(GxRecording));
+}
+
+/**
+ * @brief Get the number of parameter words of a command
+ *
+ * @param command
+ * @return int -1 if the command is not used by the game
+ */
+int GxCommandParams(uint32_t command)
+{
+	switch (command)
+	{
+	case GX_CMD_MTX_PUSH:
+	case GX_CMD_MTX_IDENTITY:
+	case GX_CMD_END_VTXS:
+		return 0;
+	case GX_CMD_MTX_MODE:
+	case GX_CMD_MTX_POP:
+	case GX_CMD_COLOR:
+	case GX_CMD_NORMAL:
+	case GX_CMD_TEXCOORD:
+	case GX_CMD_VTX_10:
+	case GX_CMD_POLYGON_ATTR:
+	case GX_CMD_TEXIMAGE_PARAM:
+	case GX_CMD_PLTT_BASE:
+	case GX_CMD_BEGIN_VTXS:
+		return 1;
+	case GX_CMD_VTX_16:
+		return 2;
+	case GX_CMD_MTX_SCALE:
+	case GX_CMD_MTX_TRANS:
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+/**
+ * @brief Count a vertex, and the polygon it completes
+ *
+ */
+static void GxCountVertex()
+{
+	if (gxPrimitive < 0)
+	{
+		gxCounters.errors++;
+		return;
+	}
+
+	gxCounters.vertices++;
+	gxPrimitiveVertices++;
+	bool completes = false;
+	switch (gxPrimitive)
+	{
+	case GX_TRIANGLES:
+		completes = gxPrimitiveVertices % 3 == 0;
+		break;
+	case GX_QUADS:
+		completes = gxPrimitiveVertices % 4 == 0;
+		break;
+	case GX_TRIANGLE_STRIP:
+		completes = gxPrimitiveVertices >= 3;
+		break;
+	case GX_QUAD_STRIP:
+		completes = gxPrimitiveVertices >= 4 && gxPrimitiveVertices % 2 == 0;
+		break;
+	}
+	if (completes)
+		gxCounters.polygons++;
+}
+
+/**
+ * @brief Append a command to the recording and update the counters
+ *
+ * @param command
+ * @param params GxCommandParams(command) words
+ */
+static void GxRecord(uint32_t command, const uint32_t *params)
+{
+	int paramCount = GxCommandParams(command);
+	if (gxRecording.size + 1 + paramCount > gxRecording.capacity)
+	{
+		int capacity = gxRecording.capacity ? gxRecording.capacity * 2 : 4096;
+		uint32_t *words = realloc(gxRecording.words, capacity * sizeof(uint32_t));
+		if (!words)
+		{
+			gxCounters.errors++;
+			return;
+		}
+		gxRecording.words = words;
+		gxRecording.capacity = capacity;
+	}
+	gxRecording.words[gxRecording.size++] = command;
+	for (int i = 0; i < paramCount; i++)
+		gxRecording.words[gxRecording.size++] = params[i];
+
+	gxCounters.commands++;
+	switch (command)
+	{
+	case GX_CMD_MTX_PUSH:
+		gxCounters.matrixPushes++;
+		if (++gxCounters.matrixDepth > GX_MATRIX_STACK_DEPTH)
+			gxCounters.errors++;
+		if (gxCounters.matrixDepth > gxCounters.maxMatrixDepth)
+			gxCounters.maxMatrixDepth = gxCounters.matrixDepth;
+		break;
+	case GX_CMD_MTX_POP:
+		// 6 bit signed offset
+		gxCounters.matrixDepth -= (int32_t)(params[0] << 26) >> 26;
+		if (gxCounters.matrixDepth < 0)
+			gxCounters.errors++;
+		break;
+	case GX_CMD_BEGIN_VTXS:
+		gxPrimitive = params[0] & 3;
+		gxPrimitiveVertices = 0;
+		break;
+	case GX_CMD_END_VTXS:
+		gxPrimitive = -1;
+		break;
+	case GX_CMD_VTX_16:
+	case GX_CMD_VTX_10:
+		GxCountVertex();
+		break;
+	}
+}
+
+void GxPolyFormat(int alpha, int id, int lights, int culling, int other)
+{
+	uint32_t format = (uint32_t)alpha << 16 | (uint32_t)id << 24 | lights | culling | other;
+	GxRecord(GX_CMD_POLYGON_ATTR, &format);
+}
+
+void GxMaterialUse(GxMaterial *material)
+{
+	uint32_t id = material ? material->id : 0;
+	GxRecord(GX_CMD_TEXIMAGE_PARAM, &id);
+}
+
+void GxBegin(int type)
+{
+	uint32_t param = type;
+	GxRecord(GX_CMD_BEGIN_VTXS, &param);
+}
+
+void GxEnd()
+{
+	GxRecord(GX_CMD_END_VTXS, NULL);
+}
+
+void GxColor(uint32_t color)
+{
+	GxRecord(GX_CMD_COLOR, &color);
+}
+
+void GxTexCoord(uint32_t uv)
+{
+	GxRecord(GX_CMD_TEXCOORD, &uv);
+}
+
+void GxVertex16(int x, int y, int z)
+{
+	uint32_t params[2] = {(uint32_t)y << 16 | (x & 0xFFFF), z & 0xFFFF};
+	GxRecord(GX_CMD_VTX_16, params);
+}
+
+void GxPushMatrix()
+{
+	GxRecord(GX_CMD_MTX_PUSH, NULL);
+}
+
+void GxPopMatrix(int count)
+{
+	uint32_t param = count & 0x3F;
+	GxRecord(GX_CMD_MTX_POP, &param);
+}
+
+void GxTranslate(int32_t x, int32_t y, int32_t z)
+{
+	uint32_t params[3] = {x, y, z};
+	GxRecord(GX_CMD_MTX_TRANS, params);
+}
+
+void GxScale(int32_t x, int32_t y, int32_t z)
+{
+	uint32_t params[3] = {x, y, z};
+	GxRecord(GX_CMD_MTX_SCALE, params);
+}
+
+/**
+ * @brief Record the commands of a display list, packed 4 command ids per header word
+ *
+ * @param list Word count followed by the packed commands, like glCallList
+ */
+void GxCallList(const uint32_t *list)
+{
+	gxCounters.lists++;
+	const uint32_t *word = list + 1;
+	const uint32_t *end = word + list[0];
+	while (word < end)
+	{
+		uint32_t header = *word++;
+		for (int i = 0; i < 4; i++)
+		{
+			uint32_t command = (header >> (i * 8)) & 0xFF;
+			// Unused command slots are NOPs without parameters
+			if (command == 0)
+				continue;
+
+			int paramCount = GxCommandParams(command);
+			if (paramCount < 0 || word + paramCount > end)
+			{
+				gxCounters.errors++;
+				return;
+			}
+			GxRecord(command, word);
+			word += paramCount;
+		}
+	}
+}
+
+/**
+ * @brief Get the vertex and polygon RAM used by the recorded commands
+ *
+ * @param budget
+ * @return true if both fit in the DS limits
+ */
+bool GxBudgetCheck(GxBudget *budget)
+{
+	budget->vertices = gxCounters.vertices;
+	budget->polygons = gxCounters.polygons;
+	return budget->vertices <= GX_VERTEX_RAM_LIMIT && budget->polygons <= GX_POLYGON_RAM_LIMIT;
+}
+
+#else
+/**
+ * @brief Get the vertex and polygon RAM used by the last rendered frame
+ *
+ * @param budget
+ * @return true if both fit in the DS limits
+ */
+bool GxBudgetCheck(GxBudget *budget)
+{
+	budget->vertices = NE_GetVertexCount();
+	budget->polygons = NE_GetPolygonCount();
+	return budget->vertices <= GX_VERTEX_RAM_LIMIT && budget->polygons <= GX_POLYGON_RAM_LIMIT;
+}
+#endif
@@ -0,0 +1,199 @@
+#ifndef GX_H_ /* Include guard */
+#define GX_H_
+
+// Geometry engine commands of the draw paths.
+// The game sends them to the hardware, the host tools record them with the counters of the DS limits.
+#include <stdbool.h>
+#include <stdint.h>
+
+// Vertex and polygon RAM of the DS, per frame
+#define GX_VERTEX_RAM_LIMIT 6144
+#define GX_POLYGON_RAM_LIMIT 2048
+// Entries of the position matrix stack
+#define GX_MATRIX_STACK_DEPTH 31
+
+// Geometry engine command ids
+#define GX_CMD_MTX_MODE 0x10
+#define GX_CMD_MTX_PUSH 0x11
+#define GX_CMD_MTX_POP 0x12
+#define GX_CMD_MTX_IDENTITY 0x15
+#define GX_CMD_MTX_SCALE 0x1B
+#define GX_CMD_MTX_TRANS 0x1C
+#define GX_CMD_COLOR 0x20
+#define GX_CMD_NORMAL 0x21
+#define GX_CMD_TEXCOORD 0x22
+#define GX_CMD_VTX_16 0x23
+#define GX_CMD_VTX_10 0x24
+#define GX_CMD_POLYGON_ATTR 0x29
+#define GX_CMD_TEXIMAGE_PARAM 0x2A
+#define GX_CMD_PLTT_BASE 0x2B
+#define GX_CMD_BEGIN_VTXS 0x40
+#define GX_CMD_END_VTXS 0x41
+
+// Header word of a display list, four command ids run in order
+#define GX_PACK(c1, c2, c3, c4) ((c1) | (c2) << 8 | (c3) << 16 | (c4) << 24)
+
+// Primitive types of GxBegin
+#define GX_TRIANGLES 0
+#define GX_QUADS 1
+#define GX_TRIANGLE_STRIP 2
+#define GX_QUAD_STRIP 3
+
+// Use of the vertex and polygon RAM of a frame
+typedef struct
+{
+    int vertices;
+    int polygons;
+} GxBudget;
+
+bool GxBudgetCheck(GxBudget *budget);
+
+#ifdef ARM9
+#include <NEMain.h>
+
+typedef NE_Material GxMaterial;
+
+// Polygon format flags of GxPolyFormat
+#define GX_LIGHT_0 NE_LIGHT_0
+#define GX_CULL_NONE NE_CULL_NONE
+#define GX_CULL_BACK NE_CULL_BACK
+#define GX_MODULATION NE_MODULATION
+#define GX_DEPTH_TEST_EQUAL NE_DEPTH_TEST_EQUAL
+
+static inline void GxPolyFormat(int alpha, int id, int lights, int culling, int other)
+{
+	NE_PolyFormat(alpha, id, lights, culling, other);
+}
+
+static inline void GxMaterialUse(GxMaterial *material)
+{
+	NE_MaterialUse(material);
+}
+
+static inline void GxBegin(int type)
+{
+	NE_PolyBegin(type);
+}
+
+static inline void GxEnd()
+{
+	NE_PolyEnd();
+}
+
+static inline void GxColor(uint32_t color)
+{
+	GFX_COLOR = color;
+}
+
+static inline void GxTexCoord(uint32_t uv)
+{
+	GFX_TEX_COORD = uv;
+}
+
+static inline void GxVertex16(int x, int y, int z)
+{
+	glVertex3v16(x, y, z);
+}
+
+static inline void GxPushMatrix()
+{
+	glPushMatrix();
+}
+
+static inline void GxPopMatrix(int count)
+{
+	glPopMatrix(count);
+}
+
+static inline void GxTranslate(int32_t x, int32_t y, int32_t z)
+{
+	glTranslatef32(x, y, z);
+}
+
+static inline void GxScale(int32_t x, int32_t y, int32_t z)
+{
+	glScalef32(x, y, z);
+}
+
+static inline void GxCallList(const uint32_t *list)
+{
+	glCallList(list);
+}
+
+#else
+// Host build: the commands are recorded, the materials are only ids
+typedef struct
+{
+    int id;
+} GxMaterial;
+
+// Polygon format flags in the hardware layout
+#define GX_LIGHT_0 (1 << 0)
+#define GX_CULL_BACK (2 << 6)
+#define GX_CULL_NONE (3 << 6)
+#define GX_MODULATION (0 << 4)
+#define GX_DEPTH_TEST_EQUAL (1 << 14)
+
+// Fixed point helpers of libnds used by the draw paths
+#ifndef inttov16
+#define inttov16(n) ((n) * (1 << 12))
+#endif
+#ifndef inttot16
+#define inttot16(n) ((n) * (1 << 4))
+#endif
+#ifndef inttof32
+#define inttof32(n) ((n) * (1 << 12))
+#endif
+#ifndef TEXTURE_PACK
+#define TEXTURE_PACK(u, v) (((u) & 0xFFFF) | ((v) << 16))
+#endif
+#ifndef RGB15
+#define RGB15(r, g, b) ((r) | ((g) << 5) | ((b) << 10))
+#endif
+
+/*
+ * Commands recorded since GxRecordStart, as the geometry engine receives them unpacked:
+ * a command id word followed by its parameter words.
+ */
+typedef struct
+{
+    uint32_t *words;
+    int size;
+    int capacity;
+} GxRecording;
+
+// Counters of the recorded commands, before clipping and culling so the RAM counts are upper bounds
+typedef struct
+{
+    int commands;
+    int vertices;
+    int polygons;
+    int matrixPushes;
+    int matrixDepth;
+    int maxMatrixDepth;
+    int lists;
+    int errors; // Matrix stack overflows and underflows, vertices outside a begin, unknown list commands
+} GxCounters;
+
+extern GxRecording gxRecording;
+extern GxCounters gxCounters;
+
+void GxRecordStart();
+void GxRecordFree();
+int GxCommandParams(uint32_t command);
+
+void GxPolyFormat(int alpha, int id, int lights, int culling, int other);
+void GxMaterialUse(GxMaterial *material);
+void GxBegin(int type);
+void GxEnd();
+void GxColor(uint32_t color);
+void GxTexCoord(uint32_t uv);
+void GxVertex16(int x, int y, int z);
+void GxPushMatrix();
+void GxPopMatrix(int count);
+void GxTranslate(int32_t x, int32_t y, int32_t z);
+void GxScale(int32_t x, int32_t y, int32_t z);
+void GxCallList(const uint32_t *list);
+#endif
+
+#endif // GX_H_
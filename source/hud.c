@@ -0,0 +1,241 @@
+#include "hud.h"
+#include "draw3d.h"
+#include "fbm.h"
+#include "profiler.h"
+#include "governor.h"
+#include "simclock.h"
+#include "chunk.h"
+#include "arena.h"
+#include <limits.h>
+
+// Tiles per row of the console map
+#define HUD_MAP_WIDTH 32
+// Value that is never displayed, to force the first write
+#define HUD_UNSET INT_MIN
+
+// Console used to get the font tiles and the map
+PrintConsole *hudConsole = NULL;
+
+HudNumber hudNumbers[HUD_NUMBER_COUNT] = {
+	[HUD_NUMBER_CPU] = {5, 0, 3, HUD_UNSET},
+	[HUD_NUMBER_POLYGONS] = {6, 1, 5, HUD_UNSET},
+	[HUD_NUMBER_NOISE_LAST] = {7, 2, 4, HUD_UNSET},
+	[HUD_NUMBER_NOISE_MAX] = {12, 2, 4, HUD_UNSET},
+	[HUD_NUMBER_FRAME_TIME] = {6, 3, 5, HUD_UNSET},
+	[HUD_NUMBER_QUALITY] = {9, 6, 1, HUD_UNSET},
+	[HUD_NUMBER_SIMULATION_RATE] = {6, 7, 2, HUD_UNSET},
+	[HUD_NUMBER_CAPTURE_FRAMES] = {17, 7, 6, HUD_UNSET},
+	[HUD_NUMBER_CHUNK_HIT_RATE] = {11, 8, 3, HUD_UNSET},
+	[HUD_NUMBER_CHUNK_GENERATION] = {21, 8, 5, HUD_UNSET},
+	[HUD_NUMBER_ARENA_USED] = {7, 16, 6, HUD_UNSET},
+	[HUD_NUMBER_VRAM_FREE] = {15, 17, 7, HUD_UNSET},
+};
+
+// Memory used by every arena subsystem, two per row
+HudNumber hudArenaNumbers[ARENA_SUBSYSTEM_COUNT];
+
+const char *waterModeNames[WATER_MODE_COUNT] = {
+	[WATER_MODE_PERLIN] = "Perlin  ",
+	[WATER_MODE_FAST] = "Fast    ",
+	[WATER_MODE_GERSTNER] = "Gerstner",
+	[WATER_MODE_FBM] = "fBm     ",
+	[WATER_MODE_PLAYBACK] = "Playback",
+	[WATER_MODE_PIPES] = "Pipes   ",
+	[WATER_MODE_SIMPLEX] = "Simplex ",
+	[WATER_MODE_FLOW] = "Flow    ",
+};
+
+const char *waterStyleNames[WATER_STYLE_COUNT] = {
+	[WATER_STYLE_OPAQUE] = "Opaque",
+	[WATER_STYLE_CLEAR] = "Clear ",
+	[WATER_STYLE_SKY] = "Sky   ",
+};
+
+// Mode, style and governor state currently on screen
+int hudWaterMode = HUD_UNSET;
+int hudWaterStyle = HUD_UNSET;
+int hudGovernorEnabled = HUD_UNSET;
+
+/**
+ * @brief Write a string in the console map at a position
+ *
+ * @param x Column
+ * @param y Row
+ * @param text
+ * @param length Number of characters to write
+ */
+void HudWrite(int x, int y, const char *text, int length)
+{
+	u16 *tile = &hudConsole->fontBgMap[y * HUD_MAP_WIDTH + x];
+	for (int i = 0; i < length; i++)
+		tile[i] = hudConsole->fontCurPal | (u16)(text[i] + hudConsole->fontCharOffset - hudConsole->font.asciiOffset);
+}
+
+/**
+ * @brief Write a null terminated string in the console map at a position
+ *
+ * @param x Column
+ * @param y Row
+ * @param text
+ */
+void HudWriteString(int x, int y, const char *text)
+{
+	HudWrite(x, y, text, strlen(text));
+}
+
+/**
+ * @brief Format an integer right aligned in a fixed width, without sprintf
+ *
+ * @param buffer Receives width characters, not null terminated
+ * @param value
+ * @param width
+ * @return int 0 on success, -1 if the value does not fit (the buffer is filled with '#')
+ */
+int HudFormatInt(char *buffer, int value, int width)
+{
+	bool negative = value < 0;
+	// Work on a negative value so INT_MIN does not overflow
+	int remaining = negative ? value : -value;
+	int i = width - 1;
+	do
+	{
+		if (i < 0)
+			break;
+		buffer[i--] = '0' - remaining % 10;
+		remaining /= 10;
+	} while (remaining != 0);
+
+	if (remaining != 0 || (negative && i < 0))
+	{
+		for (i = 0; i < width; i++)
+			buffer[i] = '#';
+		return -1;
+	}
+
+	if (negative)
+		buffer[i--] = '-';
+	while (i >= 0)
+		buffer[i--] = ' ';
+	return 0;
+}
+
+/**
+ * @brief Write the static text of the HUD
+ *
+ * @param console Console created by consoleDemoInit
+ */
+void HudInit(PrintConsole *console)
+{
+	hudConsole = console;
+	// The console is new when the HUD comes back from dual screen mode, every value is written again
+	for (int i = 0; i < HUD_NUMBER_COUNT; i++)
+		hudNumbers[i].value = HUD_UNSET;
+	hudWaterMode = HUD_UNSET;
+	hudWaterStyle = HUD_UNSET;
+	hudGovernorEnabled = HUD_UNSET;
+
+	char budgetText[4];
+	HudWriteString(0, 0, "CPU:    %");
+	HudWriteString(0, 1, "Poly:");
+	HudWriteString(0, 2, "Noise:     /    /");
+	HudFormatInt(budgetText, FBM_SAMPLE_BUDGET, 4);
+	HudWrite(17, 2, budgetText, 4);
+	HudWriteString(0, 3, "Time:       us");
+	HudWriteString(0, 4, "Mode:");
+	HudWriteString(0, 5, "Style:");
+	HudWriteString(0, 6, "Quality:");
+	HudWriteString(0, 7, "Sim:     Hz  Rec:");
+	HudWriteString(0, 8, "Chunk hit:    % gen:       us");
+	HudWriteString(0, 9, "A: Change water style");
+	HudWriteString(0, 10, "B: Change water mode");
+	HudWriteString(0, 11, "X: Toggle auto quality");
+	HudWriteString(0, 12, "Y: Start/stop capture");
+	HudWriteString(0, 13, "D-pad: Travel");
+	HudWriteString(0, 14, "Start: Dump memory use");
+	HudWriteString(0, 15, "Select: Dual screen map");
+
+	char sizeText[6];
+	HudWriteString(0, 16, "Arena:        /      B");
+	HudFormatInt(sizeText, ARENA_SIZE, 6);
+	HudWrite(15, 16, sizeText, 6);
+	HudWriteString(0, 17, "VRAM tex free:        B");
+	for (int i = 0; i < ARENA_SUBSYSTEM_COUNT; i++)
+	{
+		HudNumber *number = &hudArenaNumbers[i];
+		int column = (i % 2) * 16;
+		number->x = column + 8;
+		number->y = 18 + i / 2;
+		number->width = 6;
+		number->value = HUD_UNSET;
+		HudWriteString(column + 1, number->y, arenaSubsystemNames[i]);
+		HudWriteString(column + 14, number->y, "B");
+	}
+}
+
+/**
+ * @brief Set a number, the tiles are only rewritten if the value changed
+ *
+ * @param id
+ * @param value
+ */
+void HudSetNumber(HudNumberId id, int value)
+{
+	HudWriteNumber(&hudNumbers[id], value);
+}
+
+/**
+ * @brief Write a number if its value changed
+ *
+ * @param number
+ * @param value
+ */
+void HudWriteNumber(HudNumber *number, int value)
+{
+	if (number->value == value)
+		return;
+
+	char text[12];
+	HudFormatInt(text, value, number->width);
+	HudWrite(number->x, number->y, text, number->width);
+	number->value = value;
+}
+
+/**
+ * @brief Refresh the HUD values from the last frame
+ *
+ */
+void HudUpdate()
+{
+	HudSetNumber(HUD_NUMBER_CPU, NE_GetCPUPercent());
+	HudSetNumber(HUD_NUMBER_POLYGONS, NE_GetPolygonCount());
+	HudSetNumber(HUD_NUMBER_NOISE_LAST, profilerCounts[PROFILER_COUNTER_NOISE_SAMPLES].lastValue);
+	HudSetNumber(HUD_NUMBER_NOISE_MAX, profilerCounts[PROFILER_COUNTER_NOISE_SAMPLES].maxValue);
+	HudSetNumber(HUD_NUMBER_FRAME_TIME, ProfilerTicksToMicroseconds(profilerTimers[PROFILER_SECTION_FRAME].lastTicks));
+	HudSetNumber(HUD_NUMBER_QUALITY, governorLevel);
+	HudSetNumber(HUD_NUMBER_SIMULATION_RATE, simClockStepHz);
+	u32 chunkLookups = chunkCacheHits + chunkCacheMisses;
+	HudSetNumber(HUD_NUMBER_CHUNK_HIT_RATE, chunkLookups ? (u64)chunkCacheHits * 100 / chunkLookups : 0);
+	HudSetNumber(HUD_NUMBER_CHUNK_GENERATION, ProfilerTicksToMicroseconds(profilerTimers[PROFILER_SECTION_CHUNK_GENERATION].maxTicks));
+	HudSetNumber(HUD_NUMBER_ARENA_USED, arenaUsed);
+	HudSetNumber(HUD_NUMBER_VRAM_FREE, NE_TextureFreeMem());
+	for (int i = 0; i < ARENA_SUBSYSTEM_COUNT; i++)
+		HudWriteNumber(&hudArenaNumbers[i], arenaStats[i].used);
+
+	if (hudWaterMode != waterMode)
+	{
+		HudWriteString(7, 4, waterModeNames[waterMode]);
+		hudWaterMode = waterMode;
+	}
+
+	if (hudWaterStyle != waterStyle)
+	{
+		HudWriteString(7, 5, waterStyleNames[waterStyle]);
+		hudWaterStyle = waterStyle;
+	}
+
+	if (hudGovernorEnabled != governorEnabled)
+	{
+		HudWriteString(11, 6, governorEnabled ? "Auto  " : "Manual");
+		hudGovernorEnabled = governorEnabled;
+	}
+}
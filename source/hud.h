@@ -0,0 +1,38 @@
+#ifndef HUD_H_ /* Include guard */
+#define HUD_H_
+
+#include <NEMain.h>
+
+// Numbers shown on the sub screen
+typedef enum
+{
+    HUD_NUMBER_CPU,
+    HUD_NUMBER_POLYGONS,
+    HUD_NUMBER_NOISE_LAST,
+    HUD_NUMBER_NOISE_MAX,
+    HUD_NUMBER_FRAME_TIME,
+    HUD_NUMBER_QUALITY,
+    HUD_NUMBER_SIMULATION_RATE,
+    HUD_NUMBER_CAPTURE_FRAMES,
+    HUD_NUMBER_CHUNK_HIT_RATE,
+    HUD_NUMBER_CHUNK_GENERATION,
+    HUD_NUMBER_ARENA_USED,
+    HUD_NUMBER_VRAM_FREE,
+    HUD_NUMBER_COUNT
+} HudNumberId;
+
+typedef struct
+{
+    int x;     // Column of the first tile
+    int y;     // Row
+    int width; // Number of tiles, the number is right aligned
+    int value; // Value currently on screen
+} HudNumber;
+
+void HudInit(PrintConsole *console);
+void HudSetNumber(HudNumberId id, int value);
+void HudWriteNumber(HudNumber *number, int value);
+void HudUpdate();
+int HudFormatInt(char *buffer, int value, int width);
+
+#endif // HUD_H_
@@ -2,55 +2,209 @@
 #include "draw3d.h"
 #include "draw3d.h"
 #include "noise.h"
+#include "profiler.h"
+#include "hud.h"
+#include "governor.h"
+#include "fbm.h"
+#include "simclock.h"
+#include "wateranim.h"
+#include "capture.h"
+#include "chunk.h"
+#include "arena.h"
+#include "gx.h"
+#include <filesystem.h>
+#include <fat.h>
 #include <time.h>
 
-// Asset from Nitro Engine's font example
-#include "text_bmp_bin.h"
+#define CAPTURE_PATH "fat:/water.wcap"
+#define MEMORY_DUMP_PATH "fat:/memory.txt"
 
-NE_Material *TextMaterial = NULL;
-NE_Palette *textPalette = NULL;
+// Every profiler section is recorded in the capture frames, Y would do nothing if they did not fit
+_Static_assert(PROFILER_SECTION_COUNT <= CAPTURE_MAX_TIMERS, "The capture frames have no room for every profiler section");
 
-int main(void)
+// Recording of the simulation output for offline analysis
+CaptureWriter captureWriter;
+CaptureFrame captureFrame;
+bool capturing = false;
+bool fatReady = false;
+// The bottom screen shows a map of the grid instead of the HUD, each screen is drawn every other frame
+bool dualScreen = false;
+
+/**
+ * @brief Start or stop recording the water and sand grids to the SD card
+ *
+ */
+void ToggleCapture()
 {
-	irqEnable(IRQ_HBLANK);
-	irqSet(IRQ_VBLANK, NE_VBLFunc);
-	irqSet(IRQ_HBLANK, NE_HBLFunc);
-	srand(time(NULL));
+	if (capturing)
+	{
+		CaptureWriterClose(&captureWriter);
+		CaptureFrameFree(&captureFrame);
+		capturing = false;
+		return;
+	}
+
+	if (!fatReady || CaptureFrameAlloc(&captureFrame, WATER_SIZE * WATER_SIZE) != 0)
+		return;
+
+	if (CaptureWriterOpen(&captureWriter, CAPTURE_PATH, WATER_SIZE, WATER_SIZE, PROFILER_SECTION_COUNT) != 0)
+	{
+		CaptureFrameFree(&captureFrame);
+		return;
+	}
+	capturing = true;
+}
 
-	// Set sand height
-	float sandXOff = 10;
-	float sandYOff = 5;
+/**
+ * @brief Record the grids and the profiler timings of the last frame
+ *
+ */
+void CaptureCurrentFrame()
+{
+	int cell = 0;
 	for (int x = 0; x < WATER_SIZE; x++)
 	{
 		for (int y = 0; y < WATER_SIZE; y++)
 		{
-			// Set sand height from noise
-			sandHeight[x][y].height = noise2((x + sandXOff) / 4.0, (y + sandYOff) / 4.0) * 2 - 1;
-			// Get height int version for fast water simulation
-			sandHeight[x][y].intHeight = sandHeight[x][y].height * 4096;
+			captureFrame.heights[cell] = water[x][y].finalHeight;
+			captureFrame.colors[cell] = water[x][y].color;
+			captureFrame.sand[cell] = sandHeight[x][y].intHeight;
+			cell++;
 		}
 	}
+	for (int i = 0; i < PROFILER_SECTION_COUNT; i++)
+		captureFrame.timers[i] = profilerTimers[i].lastTicks;
 
-	// Init the engine
-	NE_Init3D();
-	consoleDemoInit();
+	// Stop on write errors (full card)
+	if (CaptureWriterAddFrame(&captureWriter, &captureFrame) != 0)
+		ToggleCapture();
+}
 
-	// Set camera settings
+/**
+ * @brief Apply the settings of a governor quality level to the water
+ *
+ * @param settings
+ */
+void ApplyQualityLevel(const GovernorLevel *settings)
+{
+	SetWaterDetail(settings->updateInterval, settings->meshStep);
+	FbmSetOctaveCount(settings->octaveCount);
+	SimClockSetRate(settings->stepHz);
+}
+
+/**
+ * @brief Set the render distance and the clear color, after every engine init
+ *
+ */
+void InitEngine()
+{
 	NE_ClippingPlanesSetI(floattof32(0.1), floattof32(90.0)); // Set render distance
 	NE_AntialiasEnable(true);
 	NE_ClearColorSet(RGB15(0, 0, 0), 31, 63); // Black sky
+}
 
-	// Load font
-	textPalette = NE_PaletteCreate();
-	TextMaterial = NE_MaterialCreate();
-	NE_MaterialTexLoadBMPtoRGB256(TextMaterial, textPalette, (void *)text_bmp_bin, true); // Load bmp font format
+/**
+ * @brief Switch between the HUD and the map on the bottom screen
+ *
+ * The engine is restarted for the other screen mode, the simulation keeps running
+ *
+ */
+void ToggleDualScreen()
+{
+	dualScreen = !dualScreen;
+
+	// The cameras, materials and palettes are freed with the engine
+	NE_End();
+	if (dualScreen)
+		NE_InitDual3D();
+	else
+		NE_Init3D();
+	InitEngine();
+
+	// Display capture uses the VRAM banks of the console in dual screen mode
+	if (!dualScreen)
+		HudInit(consoleDemoInit());
+	LoadGraphics();
+	ProfilerResetScreenRates();
+}
 
-	// Create font
-	NE_TextInit(0,			  // Font slot
-				TextMaterial, // Image
-				8, 8);		  // Size of one character (x, y)
+/**
+ * @brief Write the memory use of every subsystem and of the geometry engine to the SD card
+ *
+ */
+void DumpMemoryUse()
+{
+	if (!fatReady)
+		return;
 
+	FILE *file = fopen(MEMORY_DUMP_PATH, "w");
+	if (!file)
+		return;
+	ArenaDump(file);
+	fprintf(file, "VRAM texture free: %d bytes\n", NE_TextureFreeMem());
+	fprintf(file, "Texture load at boot: %d us\n", ProfilerTicksToMicroseconds(profilerTimers[PROFILER_SECTION_TEXTURE_LOAD].maxTicks));
+	GxBudget budget;
+	bool inBudget = GxBudgetCheck(&budget);
+	fprintf(file, "Last frame: %d/%d vertices, %d/%d polygons%s\n", budget.vertices, GX_VERTEX_RAM_LIMIT,
+			budget.polygons, GX_POLYGON_RAM_LIMIT, inBudget ? "" : ", over budget");
+	fprintf(file, "Dual screen: %s\n", dualScreen ? "on" : "off");
+	const char *screenNames[PROFILER_SCREEN_COUNT] = {"Top", "Bottom"};
+	for (int i = 0; i < PROFILER_SCREEN_COUNT; i++)
+	{
+		ProfilerScreenRate *rate = &profilerScreenRates[i];
+		fprintf(file, "%s screen: %d fps, %d%% CPU, %d us per frame\n", screenNames[i], rate->fps, rate->cpuPercent,
+				ProfilerTicksToMicroseconds(rate->frameTicks));
+	}
+	fclose(file);
+}
+
+/**
+ * @brief VBlank interrupt, counts the simulation time before running the engine's handler
+ *
+ */
+void VBlankHandler()
+{
+	SimClockVBlank();
+	NE_VBLFunc();
+}
+
+int main(void)
+{
+	irqEnable(IRQ_HBLANK);
+	irqSet(IRQ_VBLANK, VBlankHandler);
+	irqSet(IRQ_HBLANK, NE_HBLFunc);
+	srand(time(NULL));
+
+	// Set sand height from the chunks under the grid
+	AllocateWaterGrids();
+	ChunkCacheInit();
+	ChunkFillSand(0, 0);
+
+	// Init the engine
+	NE_Init3D();
+	PrintConsole *console = consoleDemoInit();
+
+	// Set camera settings
+	InitEngine();
+
+	// Stats and key help on the sub screen
+	HudInit(console);
+
+	ProfilerInit();
+
+	// The SD card is only used to record captures
+	fatReady = fatInitDefault();
+
+	// The playback water mode is only available if the animation can be streamed
+	if (nitroFSInit(NULL))
+		WaterAnimOpen(WATER_ANIM_PATH);
+
+	// Keep moving while the d-pad is held
+	keysSetRepeat(15, 4);
+
+	SimClockInit(SIM_CLOCK_SOURCE_HZ);
 	InitGraphics();
+	GovernorInit(ApplyQualityLevel);
 
 	// Init water grid
 	UpdateWater(true);
@@ -61,12 +215,58 @@ int main(void)
 		// Check player inputs
 		scanKeys();
 		int keysdown = keysDown();
+		int keysrepeat = keysDownRepeat();
 		if (keysdown & KEY_A)
 			ChangeWaterStyle();
 		if (keysdown & KEY_B)
 			ChangeWaterMode();
+		if (keysdown & KEY_X)
+			governorEnabled = !governorEnabled;
+		if (keysdown & KEY_Y)
+			ToggleCapture();
+		if (keysdown & KEY_START)
+			DumpMemoryUse();
+		if (keysdown & KEY_SELECT)
+			ToggleDualScreen();
+
+		// Travel over the ocean
+		int moveX = 0;
+		int moveY = 0;
+		if (keysrepeat & KEY_LEFT)
+			moveX--;
+		if (keysrepeat & KEY_RIGHT)
+			moveX++;
+		if (keysrepeat & KEY_UP)
+			moveY--;
+		if (keysrepeat & KEY_DOWN)
+			moveY++;
+		if (moveX != 0 || moveY != 0)
+			MoveWorld(moveX, moveY);
 
-		NE_Process(Draw3DScene);
-		NE_WaitForVBL(NE_CAN_SKIP_VBL);
+		ProfilerBegin(PROFILER_SECTION_FRAME);
+		if (dualScreen)
+			NE_ProcessDual(Draw3DScene, DrawMapScene);
+		else
+			NE_Process(Draw3DScene);
+		ProfilerEnd(PROFILER_SECTION_FRAME);
+		ProfilerNextFrame();
+		// In dual screen mode only the top screen frames run the simulation and draw the water, the map
+		// frames in between would record the same grids again and break the governor runs of heavy frames
+		bool topScreenFrame = !dualScreen || profilerTimers[PROFILER_SECTION_TOP_SCREEN].lastTicks != 0;
+		if (capturing && topScreenFrame)
+			CaptureCurrentFrame();
+		// Read the next animation frames while waiting for the VBlank
+		WaterAnimPrefetch();
+		// Adapt the quality to the cost of the frame
+		if (topScreenFrame)
+			GovernorUpdate(profilerTimers[PROFILER_SECTION_FRAME].lastTicks, NE_GetPolygonCount());
+		// There is no HUD console in dual screen mode
+		if (!dualScreen)
+		{
+			HudSetNumber(HUD_NUMBER_CAPTURE_FRAMES, capturing ? captureWriter.frameCount : 0);
+			HudUpdate();
+		}
+		// The screens are swapped every frame in dual screen mode, a skipped VBlank would show a screen twice
+		NE_WaitForVBL(dualScreen ? 0 : NE_CAN_SKIP_VBL);
 	}
 }
\ No newline at end of file
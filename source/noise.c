@@ -1,5 +1,3 @@
-#include <NEMain.h>
-
 // noise1234
 //
 // Author: Stefan Gustavson, 2003-2005
@@ -525,4 +523,210 @@ float pnoise4(float x, float y, float z, float w,
 	return 0.87f * (LERP(s, n0, n1));
 }
 
-//---------------------------------------------------------------------
\ No newline at end of file
+//---------------------------------------------------------------------
+/*
+ * Fixed point simplex noise, 20.12 in and out (4096 = 1.0).
+ * A simplex has 3 corners in 2D and 4 in 3D, against 4 and 8 cell
+ * corners for Perlin noise, and there is no interpolation to compute.
+ * The values are in the [0,1] range (0 to 4096) like noise2.
+ */
+
+// Skew and unskew factors: (sqrt(3) - 1) / 2, (3 - sqrt(3)) / 6, 1 / 3 and 1 / 6
+#define SIMPLEX_F2 1499
+#define SIMPLEX_G2 866
+#define SIMPLEX_F3 1365
+#define SIMPLEX_G3 683
+// Squared radius of the corner contributions
+#define SIMPLEX_R2 2048
+#define SIMPLEX_R3 2458
+// Scales of the sums of the contributions, measured: the 2D sum peaks at 1452 and reaches the
+// [0, 4096] range of noise2, the 3D one matches the spread of noise3 for the water mode
+#define SIMPLEX_SCALE2 45
+#define SIMPLEX_SCALE3 24
+
+/**
+ * @brief Clamp a scaled simplex sum to [0, 4096]
+ *
+ */
+static inline int simplexOutput(int sum, int scale)
+{
+	int value = 2048 + ((sum * scale) >> 5);
+	if (value < 0)
+		return 0;
+	if (value > 4096)
+		return 4096;
+	return value;
+}
+
+/**
+ * @brief Contribution of a 2D simplex corner
+ *
+ */
+static inline int simplexCorner2(int hash, int x, int y)
+{
+	int t = SIMPLEX_R2 - ((x * x + y * y) >> 12);
+	if (t <= 0)
+		return 0;
+	// The fourth power keeps 4 more bits, the contributions are small
+	t = (t * t) >> 12;
+	t = (t * t) >> 8;
+	// Same 8 gradients as grad2
+	int h = hash & 7;
+	int u = h < 4 ? x : y;
+	int v = h < 4 ? y : x;
+	int dot = ((h & 1) ? -u : u) + ((h & 2) ? -2 * v : 2 * v);
+	return (t * dot + 2048) >> 12;
+}
+
+/**
+ * @brief Contribution of a 3D simplex corner
+ *
+ */
+static inline int simplexCorner3(int hash, int x, int y, int z)
+{
+	int t = SIMPLEX_R3 - ((x * x + y * y + z * z) >> 12);
+	if (t <= 0)
+		return 0;
+	t = (t * t) >> 12;
+	t = (t * t) >> 8;
+	// Same 12 gradients as grad3
+	int h = hash & 15;
+	int u = h < 8 ? x : y;
+	int v = h < 4 ? y : h == 12 || h == 14 ? x
+										   : z;
+	int dot = ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+	return (t * dot + 2048) >> 12;
+}
+
+/**
+ * @brief 2D simplex noise sum, x + y is given so the rows can skew incrementally
+ *
+ */
+static inline int simplexSum2(int x, int y, int sum)
+{
+	// Skew to find the cell, the 64 bits product keeps large offsets exact
+	int skew = ((long long)sum * SIMPLEX_F2) >> 12;
+	int i = (x + skew) >> 12;
+	int j = (y + skew) >> 12;
+	int unskew = (i + j) * SIMPLEX_G2;
+	int x0 = x - (i << 12) + unskew;
+	int y0 = y - (j << 12) + unskew;
+
+	// Lower or upper triangle of the cell
+	int i1 = x0 > y0;
+	int j1 = !i1;
+	int x1 = x0 - (i1 << 12) + SIMPLEX_G2;
+	int y1 = y0 - (j1 << 12) + SIMPLEX_G2;
+	int x2 = x0 - 4096 + 2 * SIMPLEX_G2;
+	int y2 = y0 - 4096 + 2 * SIMPLEX_G2;
+
+	int ii = i & 0xff;
+	int jj = j & 0xff;
+	return simplexCorner2(perm[ii + perm[jj]], x0, y0) +
+		   simplexCorner2(perm[ii + i1 + perm[jj + j1]], x1, y1) +
+		   simplexCorner2(perm[ii + 1 + perm[jj + 1]], x2, y2);
+}
+
+/**
+ * @brief 3D simplex noise sum, x + y + z is given so the rows can skew incrementally
+ *
+ */
+static inline int simplexSum3(int x, int y, int z, int sum)
+{
+	int skew = ((long long)sum * SIMPLEX_F3) >> 12;
+	int i = (x + skew) >> 12;
+	int j = (y + skew) >> 12;
+	int k = (z + skew) >> 12;
+	int unskew = (i + j + k) * SIMPLEX_G3;
+	int x0 = x - (i << 12) + unskew;
+	int y0 = y - (j << 12) + unskew;
+	int z0 = z - (k << 12) + unskew;
+
+	// Second and third corners of the tetrahedron, from the order of the offsets
+	int i1, j1, k1, i2, j2, k2;
+	if (x0 >= y0)
+	{
+		if (y0 >= z0)
+		{
+			i1 = 1, j1 = 0, k1 = 0, i2 = 1, j2 = 1, k2 = 0;
+		}
+		else if (x0 >= z0)
+		{
+			i1 = 1, j1 = 0, k1 = 0, i2 = 1, j2 = 0, k2 = 1;
+		}
+		else
+		{
+			i1 = 0, j1 = 0, k1 = 1, i2 = 1, j2 = 0, k2 = 1;
+		}
+	}
+	else
+	{
+		if (y0 < z0)
+		{
+			i1 = 0, j1 = 0, k1 = 1, i2 = 0, j2 = 1, k2 = 1;
+		}
+		else if (x0 < z0)
+		{
+			i1 = 0, j1 = 1, k1 = 0, i2 = 0, j2 = 1, k2 = 1;
+		}
+		else
+		{
+			i1 = 0, j1 = 1, k1 = 0, i2 = 1, j2 = 1, k2 = 0;
+		}
+	}
+
+	int ii = i & 0xff;
+	int jj = j & 0xff;
+	int kk = k & 0xff;
+	return simplexCorner3(perm[ii + perm[jj + perm[kk]]], x0, y0, z0) +
+		   simplexCorner3(perm[ii + i1 + perm[jj + j1 + perm[kk + k1]]],
+						  x0 - (i1 << 12) + SIMPLEX_G3, y0 - (j1 << 12) + SIMPLEX_G3, z0 - (k1 << 12) + SIMPLEX_G3) +
+		   simplexCorner3(perm[ii + i2 + perm[jj + j2 + perm[kk + k2]]],
+						  x0 - (i2 << 12) + 2 * SIMPLEX_G3, y0 - (j2 << 12) + 2 * SIMPLEX_G3, z0 - (k2 << 12) + 2 * SIMPLEX_G3) +
+		   simplexCorner3(perm[ii + 1 + perm[jj + 1 + perm[kk + 1]]],
+						  x0 - 4096 + 3 * SIMPLEX_G3, y0 - 4096 + 3 * SIMPLEX_G3, z0 - 4096 + 3 * SIMPLEX_G3);
+}
+
+//---------------------------------------------------------------------
+/** 2D fixed point simplex noise.
+ */
+int simplex2(int x, int y)
+{
+	return simplexOutput(simplexSum2(x, y, x + y), SIMPLEX_SCALE2);
+}
+
+//---------------------------------------------------------------------
+/** 3D fixed point simplex noise.
+ */
+int simplex3(int x, int y, int z)
+{
+	return simplexOutput(simplexSum3(x, y, z, x + y + z), SIMPLEX_SCALE3);
+}
+
+//---------------------------------------------------------------------
+/** 2D fixed point simplex noise on count points from (x, y), stepping on x.
+ */
+void simplex2Row(int *out, int count, int x, int y, int stepX)
+{
+	int sum = x + y;
+	for (int n = 0; n < count; n++)
+	{
+		out[n] = simplexOutput(simplexSum2(x, y, sum), SIMPLEX_SCALE2);
+		x += stepX;
+		sum += stepX;
+	}
+}
+
+//---------------------------------------------------------------------
+/** 3D fixed point simplex noise on count points from (x, y, z), stepping on x.
+ */
+void simplex3Row(int *out, int count, int x, int y, int z, int stepX)
+{
+	int sum = x + y + z;
+	for (int n = 0; n < count; n++)
+	{
+		out[n] = simplexOutput(simplexSum3(x, y, z, sum), SIMPLEX_SCALE3);
+		x += stepX;
+		sum += stepX;
+	}
+}
@@ -13,5 +13,9 @@ float noise3(float x, float y, float z);
 float pnoise3(float x, float y, float z, int px, int py, int pz);
 float noise4(float x, float y, float z, float w);
 float pnoise4(float x, float y, float z, float w, int px, int py, int pz, int pw);
+int simplex2(int x, int y);
+int simplex3(int x, int y, int z);
+void simplex2Row(int *out, int count, int x, int y, int stepX);
+void simplex3Row(int *out, int count, int x, int y, int z, int stepX);
 
 #endif // NOISE_H_
\ No newline at end of file
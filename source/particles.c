@@ -0,0 +1,208 @@
+#include "particles.h"
+#include "gx.h"
+#include <stdbool.h>
+
+// Number of int32_t arrays in the buffer: position, velocity and life
+#define PARTICLES_ARRAY_COUNT 7
+
+/**
+ * @brief Get the size of the buffer needed by a pool
+ *
+ * @param capacity Maximum number of live particles
+ * @return int Size in bytes
+ */
+int ParticlesBufferSize(int capacity)
+{
+	return PARTICLES_ARRAY_COUNT * capacity * sizeof(int32_t);
+}
+
+/**
+ * @brief Get the size of the display list of a full pool
+ *
+ * @param capacity Maximum number of live particles
+ * @return int Size in bytes, with the word count at the start of the list
+ */
+int ParticlesListSize(int capacity)
+{
+	return (1 + capacity * PARTICLES_LIST_WORDS_PER_PARTICLE) * sizeof(uint32_t);
+}
+
+/**
+ * @brief Init an empty pool
+ *
+ * @param pool
+ * @param capacity Maximum number of live particles
+ * @param buffer ParticlesBufferSize bytes, 4 bytes aligned
+ */
+void ParticlesInit(ParticlePool *pool, int capacity, void *buffer)
+{
+	int32_t *arrays = buffer;
+	pool->capacity = capacity;
+	pool->x = arrays;
+	pool->y = arrays + capacity;
+	pool->z = arrays + capacity * 2;
+	pool->velocityX = arrays + capacity * 3;
+	pool->velocityY = arrays + capacity * 4;
+	pool->velocityZ = arrays + capacity * 5;
+	pool->life = arrays + capacity * 6;
+	pool->random = 1;
+	ParticlesClear(pool);
+}
+
+/**
+ * @brief Kill all the particles
+ *
+ * @param pool
+ */
+void ParticlesClear(ParticlePool *pool)
+{
+	pool->count = 0;
+	pool->spawnFailures = 0;
+}
+
+/**
+ * @brief Get the next value of the jitter generator
+ *
+ * @param pool
+ * @param range
+ * @return int32_t Value between 0 and range - 1, range must be a power of two
+ */
+static inline int32_t ParticlesRandom(ParticlePool *pool, int32_t range)
+{
+	pool->random = pool->random * 1664525u + 1013904223u;
+	return (pool->random >> 16) & (range - 1);
+}
+
+/**
+ * @brief Spawn particles going up from a point with a random horizontal speed
+ *
+ * @param pool
+ * @param x Position in 20.12 fixed point world units
+ * @param y
+ * @param z
+ * @param velocityY Minimum vertical speed, up to 1.5 times this speed
+ * @param count Number of particles
+ * @return int Number of particles spawned, less than count if the pool is full
+ */
+int ParticlesSpawn(ParticlePool *pool, int32_t x, int32_t y, int32_t z, int32_t velocityY, int count)
+{
+	int freeCount = pool->capacity - pool->count;
+	if (count > freeCount)
+	{
+		pool->spawnFailures += count - freeCount;
+		count = freeCount;
+	}
+
+	for (int i = pool->count; i < pool->count + count; i++)
+	{
+		pool->x[i] = x;
+		pool->y[i] = y;
+		pool->z[i] = z;
+		pool->velocityX[i] = ParticlesRandom(pool, PARTICLES_SPREAD * 2) - PARTICLES_SPREAD;
+		pool->velocityY[i] = velocityY + (((velocityY >> 1) * ParticlesRandom(pool, 4096)) >> 12);
+		pool->velocityZ[i] = ParticlesRandom(pool, PARTICLES_SPREAD * 2) - PARTICLES_SPREAD;
+		pool->life[i] = PARTICLES_LIFE + ParticlesRandom(pool, PARTICLES_LIFE_JITTER);
+	}
+	pool->count += count;
+	return count;
+}
+
+/**
+ * @brief Move the particles and remove the dead ones
+ *
+ * @param pool
+ * @param frames 60 Hz frames since the last update
+ */
+void ParticlesUpdate(ParticlePool *pool, int frames)
+{
+	int count = pool->count;
+
+	// Integrate every array on its own
+	int32_t gravity = PARTICLES_GRAVITY * frames;
+	for (int i = 0; i < count; i++)
+		pool->velocityY[i] -= gravity;
+	for (int i = 0; i < count; i++)
+		pool->x[i] += pool->velocityX[i] * frames;
+	for (int i = 0; i < count; i++)
+		pool->y[i] += pool->velocityY[i] * frames;
+	for (int i = 0; i < count; i++)
+		pool->z[i] += pool->velocityZ[i] * frames;
+	for (int i = 0; i < count; i++)
+		pool->life[i] -= frames;
+
+	// Replace the dead particles by the last ones to keep the live particles contiguous
+	for (int i = 0; i < count;)
+	{
+		bool outside = (uint32_t)pool->x[i] > PARTICLES_MAX_POSITION ||
+					   (uint32_t)pool->y[i] > PARTICLES_MAX_POSITION ||
+					   (uint32_t)pool->z[i] > PARTICLES_MAX_POSITION;
+		if (pool->life[i] > 0 && !outside)
+		{
+			i++;
+			continue;
+		}
+
+		count--;
+		pool->x[i] = pool->x[count];
+		pool->y[i] = pool->y[count];
+		pool->z[i] = pool->z[count];
+		pool->velocityX[i] = pool->velocityX[count];
+		pool->velocityY[i] = pool->velocityY[count];
+		pool->velocityZ[i] = pool->velocityZ[count];
+		pool->life[i] = pool->life[count];
+	}
+	pool->count = count;
+}
+
+/**
+ * @brief Write a display list drawing every particle as a quad facing the camera
+ *
+ * The list has to be called between a quad begin and end, with a scale of 1 << PARTICLES_DRAW_SCALE_SHIFT
+ *
+ * @param pool
+ * @param list ParticlesListSize bytes
+ * @param rightX Camera right vector on x in 20.12 fixed point, the quads are vertical
+ * @param rightZ Camera right vector on z
+ * @return int Number of words written, including the word count at the start
+ */
+int ParticlesBuildList(const ParticlePool *pool, uint32_t *list, int32_t rightX, int32_t rightZ)
+{
+	const uint32_t header = GX_PACK(GX_CMD_COLOR, GX_CMD_VTX_16, GX_CMD_COLOR, GX_CMD_VTX_16);
+	int32_t offsetX = (rightX * PARTICLES_HALF_SIZE) >> (12 + PARTICLES_DRAW_SCALE_SHIFT);
+	int32_t offsetY = PARTICLES_HALF_SIZE >> PARTICLES_DRAW_SCALE_SHIFT;
+	int32_t offsetZ = (rightZ * PARTICLES_HALF_SIZE) >> (12 + PARTICLES_DRAW_SCALE_SHIFT);
+
+	uint32_t *word = list + 1;
+	for (int i = 0; i < pool->count; i++)
+	{
+		int32_t x = pool->x[i] >> PARTICLES_DRAW_SCALE_SHIFT;
+		int32_t y = pool->y[i] >> PARTICLES_DRAW_SCALE_SHIFT;
+		int32_t z = pool->z[i] >> PARTICLES_DRAW_SCALE_SHIFT;
+		uint32_t top = (uint32_t)(y + offsetY) << 16;
+		uint32_t bottom = (uint32_t)(y - offsetY) << 16;
+
+		// White foam fading to the water color at the end of its life
+		int32_t level = pool->life[i] < PARTICLES_FADE_FRAMES ? pool->life[i] : PARTICLES_FADE_FRAMES;
+		uint32_t topColor = RGB15(12 + level, 12 + level, 12 + level);
+		uint32_t bottomColor = RGB15(4 + level, 8 + level, 12 + level);
+
+		*word++ = header;
+		*word++ = topColor;
+		*word++ = top | ((x + offsetX) & 0xFFFF);
+		*word++ = (z + offsetZ) & 0xFFFF;
+		*word++ = bottomColor;
+		*word++ = bottom | ((x + offsetX) & 0xFFFF);
+		*word++ = (z + offsetZ) & 0xFFFF;
+
+		*word++ = header;
+		*word++ = bottomColor;
+		*word++ = bottom | ((x - offsetX) & 0xFFFF);
+		*word++ = (z - offsetZ) & 0xFFFF;
+		*word++ = topColor;
+		*word++ = top | ((x - offsetX) & 0xFFFF);
+		*word++ = (z - offsetZ) & 0xFFFF;
+	}
+
+	list[0] = word - list - 1;
+	return word - list;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef PARTICLES_H_ /* Include guard */
+#define PARTICLES_H_
+
+// Shared by the game and the host benchmark, only uses the standard headers
+#include <stdint.h>
+
+// Gravity in 20.12 fixed point world units per 60 Hz frame squared
+#define PARTICLES_GRAVITY 24
+// Life of a particle in 60 Hz frames, plus a random part, the particles fade during the last frames
+#define PARTICLES_LIFE 32
+#define PARTICLES_LIFE_JITTER 16
+#define PARTICLES_FADE_FRAMES 19
+// Random horizontal speed of the particles in 20.12 fixed point world units per 60 Hz frame
+#define PARTICLES_SPREAD 64
+// Half size of the quads in 20.12 fixed point world units
+#define PARTICLES_HALF_SIZE 600
+// Particles are killed out of this box, so the vertices fit in v16 with the draw scale
+#define PARTICLES_MAX_POSITION (31 * 4096)
+// Log2 of the world units per v16 unit, the batch is drawn scaled by 1 << PARTICLES_DRAW_SCALE_SHIFT
+#define PARTICLES_DRAW_SCALE_SHIFT 2
+// Spray particles of the game, at most SPRAY_PARTICLES quads are drawn
+#define SPRAY_PARTICLES 128
+// Display list words of a particle: 2 command headers, 4 colors and 4 vertices of 2 words
+#define PARTICLES_LIST_WORDS_PER_PARTICLE 14
+
+/*
+ * Pool of particles in structure of arrays layout.
+ * The live particles are always the first count ones, a dead particle is replaced by the last one,
+ * so every pass is a loop over count contiguous values and never more than capacity.
+ * Positions and velocities are in 20.12 fixed point world units, velocities per 60 Hz frame.
+ */
+typedef struct
+{
+    int capacity;
+    int count;
+    int32_t *x;
+    int32_t *y;
+    int32_t *z;
+    int32_t *velocityX;
+    int32_t *velocityY;
+    int32_t *velocityZ;
+    int32_t *life;      // 60 Hz frames left
+    uint32_t random;    // State of the spawn jitter generator
+    int spawnFailures;  // Particles refused because the pool was full
+} ParticlePool;
+
+int ParticlesBufferSize(int capacity);
+int ParticlesListSize(int capacity);
+void ParticlesInit(ParticlePool *pool, int capacity, void *buffer);
+void ParticlesClear(ParticlePool *pool);
+int ParticlesSpawn(ParticlePool *pool, int32_t x, int32_t y, int32_t z, int32_t velocityY, int count);
+void ParticlesUpdate(ParticlePool *pool, int frames);
+int ParticlesBuildList(const ParticlePool *pool, uint32_t *list, int32_t rightX, int32_t rightZ);
+
+#endif // PARTICLES_H_
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "pipes.h"
+#include <stdbool.h>
+#include <string.h>
+
+// Number of int32_t grids in the buffer: terrain, depth, flowX, flowY and scale
+#define PIPES_GRID_COUNT 5
+
+/**
+ * @brief Get the size of the buffer needed by a grid
+ *
+ * @param width
+ * @param height
+ * @return int Size in bytes
+ */
+int PipesBufferSize(int width, int height)
+{
+	return PIPES_GRID_COUNT * width * height * sizeof(int32_t);
+}
+
+/**
+ * @brief Init a dry grid with a flat ground and no sources
+ *
+ * @param grid
+ * @param width
+ * @param height
+ * @param buffer PipesBufferSize bytes, 4 bytes aligned
+ */
+void PipesInit(PipesGrid *grid, int width, int height, void *buffer)
+{
+	int cellCount = width * height;
+	memset(buffer, 0, PipesBufferSize(width, height));
+	grid->width = width;
+	grid->height = height;
+	grid->terrain = buffer;
+	grid->depth = grid->terrain + cellCount;
+	grid->flowX = grid->depth + cellCount;
+	grid->flowY = grid->flowX + cellCount;
+	grid->scale = grid->flowY + cellCount;
+	grid->sourceCount = 0;
+	grid->addedVolume = 0;
+}
+
+/**
+ * @brief Fill the grid with still water up to a level, cells with a higher ground are dry
+ *
+ * @param grid
+ * @param level Water surface height
+ */
+void PipesFillToLevel(PipesGrid *grid, int32_t level)
+{
+	int cellCount = grid->width * grid->height;
+	for (int i = 0; i < cellCount; i++)
+	{
+		int32_t depth = level - grid->terrain[i];
+		grid->depth[i] = depth > 0 ? depth : 0;
+	}
+	memset(grid->flowX, 0, cellCount * sizeof(int32_t));
+	memset(grid->flowY, 0, cellCount * sizeof(int32_t));
+	grid->addedVolume = 0;
+}
+
+/**
+ * @brief Add water to a cell, or remove it with a negative amount
+ *
+ * @param grid
+ * @param x
+ * @param y
+ * @param amount Depth to add
+ * @return int32_t Depth really added, a sink cannot remove more water than the cell has
+ */
+int32_t PipesAddWater(PipesGrid *grid, int x, int y, int32_t amount)
+{
+	int32_t *depth = &grid->depth[y * grid->width + x];
+	if (amount < -*depth)
+		amount = -*depth;
+	*depth += amount;
+	grid->addedVolume += amount;
+	return amount;
+}
+
+/**
+ * @brief Add a source or a sink run on every step
+ *
+ * @param grid
+ * @param x
+ * @param y
+ * @param rate Depth added every step, negative for a sink
+ * @return int Index of the source, -1 if there are already PIPES_MAX_SOURCES sources
+ */
+int PipesAddSource(PipesGrid *grid, int x, int y, int32_t rate)
+{
+	if (grid->sourceCount == PIPES_MAX_SOURCES)
+		return -1;
+
+	PipesSource *source = &grid->sources[grid->sourceCount];
+	source->x = x;
+	source->y = y;
+	source->rate = rate;
+	return grid->sourceCount++;
+}
+
+/**
+ * @brief Remove all the sources and sinks
+ *
+ * @param grid
+ */
+void PipesClearSources(PipesGrid *grid)
+{
+	grid->sourceCount = 0;
+}
+
+/**
+ * @brief Accelerate the flows of a row from the surface differences
+ *
+ * @param grid
+ * @param y Row
+ */
+static void PipesAccelerateRow(PipesGrid *grid, int y)
+{
+	int width = grid->width;
+	const int32_t *terrain = &grid->terrain[y * width];
+	const int32_t *depth = &grid->depth[y * width];
+	int32_t *flowX = &grid->flowX[y * width];
+
+	int32_t surface = terrain[0] + depth[0];
+	for (int x = 0; x < width - 1; x++)
+	{
+		int32_t nextSurface = terrain[x + 1] + depth[x + 1];
+		flowX[x] = ((flowX[x] * PIPES_DAMPING) >> 12) + (((surface - nextSurface) * PIPES_GAIN) >> 12);
+		surface = nextSurface;
+	}
+
+	// Pipes to the next row, the last row is a wall
+	if (y == grid->height - 1)
+		return;
+
+	const int32_t *nextTerrain = terrain + width;
+	const int32_t *nextDepth = depth + width;
+	int32_t *flowY = &grid->flowY[y * width];
+	for (int x = 0; x < width; x++)
+	{
+		int32_t difference = terrain[x] + depth[x] - nextTerrain[x] - nextDepth[x];
+		flowY[x] = ((flowY[x] * PIPES_DAMPING) >> 12) + ((difference * PIPES_GAIN) >> 12);
+	}
+}
+
+/**
+ * @brief Compute the outflow scale of the cells of a row
+ *
+ * @param grid
+ * @param y Row
+ */
+static void PipesScaleRow(PipesGrid *grid, int y)
+{
+	int width = grid->width;
+	const int32_t *depth = &grid->depth[y * width];
+	const int32_t *flowX = &grid->flowX[y * width];
+	const int32_t *flowY = &grid->flowY[y * width];
+	int32_t *scale = &grid->scale[y * width];
+	bool firstRow = y == 0;
+	bool lastRow = y == grid->height - 1;
+
+	for (int x = 0; x < width; x++)
+	{
+		int32_t outflow = 0;
+		if (x < width - 1 && flowX[x] > 0)
+			outflow += flowX[x];
+		if (x > 0 && flowX[x - 1] < 0)
+			outflow -= flowX[x - 1];
+		if (!lastRow && flowY[x] > 0)
+			outflow += flowY[x];
+		if (!firstRow && flowY[x - width] < 0)
+			outflow -= flowY[x - width];
+
+		// Rounded down so the scaled outflow is never more than the depth
+		if (outflow > depth[x])
+			scale[x] = ((int64_t)depth[x] << 12) / outflow;
+		else
+			scale[x] = 4096;
+	}
+}
+
+/**
+ * @brief Scale a flow by the outflow scale of the cell it comes from
+ *
+ * @param flow
+ * @param fromScale Scale of the cell on the positive side
+ * @param toScale Scale of the cell on the negative side
+ * @return int32_t
+ */
+static inline int32_t PipesScaleFlow(int32_t flow, int32_t fromScale, int32_t toScale)
+{
+	// Round the magnitude down in both directions
+	if (flow >= 0)
+		return (flow * fromScale) >> 12;
+	return -((-flow * toScale) >> 12);
+}
+
+/**
+ * @brief Limit the flows of a row and move the water through them
+ *
+ * @param grid
+ * @param y Row
+ */
+static void PipesTransportRow(PipesGrid *grid, int y)
+{
+	int width = grid->width;
+	int32_t *depth = &grid->depth[y * width];
+	int32_t *flowX = &grid->flowX[y * width];
+	const int32_t *scale = &grid->scale[y * width];
+
+	for (int x = 0; x < width - 1; x++)
+	{
+		int32_t flow = PipesScaleFlow(flowX[x], scale[x], scale[x + 1]);
+		flowX[x] = flow;
+		depth[x] -= flow;
+		depth[x + 1] += flow;
+	}
+
+	if (y == grid->height - 1)
+		return;
+
+	int32_t *nextDepth = depth + width;
+	int32_t *flowY = &grid->flowY[y * width];
+	const int32_t *nextScale = scale + width;
+	for (int x = 0; x < width; x++)
+	{
+		int32_t flow = PipesScaleFlow(flowY[x], scale[x], nextScale[x]);
+		flowY[x] = flow;
+		depth[x] -= flow;
+		nextDepth[x] += flow;
+	}
+}
+
+/**
+ * @brief Run one solver step: sources, flow acceleration, outflow limits, then transport
+ *
+ * Each pass goes over the rows in order and only reads the current and the next row
+ *
+ * @param grid
+ */
+void PipesStep(PipesGrid *grid)
+{
+	for (int i = 0; i < grid->sourceCount; i++)
+	{
+		PipesSource *source = &grid->sources[i];
+		PipesAddWater(grid, source->x, source->y, source->rate);
+	}
+
+	// The scale of a row only needs the flows of the row and of the previous one
+	for (int y = 0; y < grid->height; y++)
+	{
+		PipesAccelerateRow(grid, y);
+		PipesScaleRow(grid, y);
+	}
+
+	// The transport of a row needs the scales of the next row, a dry cell has a zero scale
+	for (int y = 0; y < grid->height; y++)
+		PipesTransportRow(grid, y);
+}
+
+/**
+ * @brief Get the total water volume, for conservation checks
+ *
+ * @param grid
+ * @return int64_t Sum of the depths
+ */
+int64_t PipesVolume(const PipesGrid *grid)
+{
+	int64_t volume = 0;
+	int cellCount = grid->width * grid->height;
+	for (int i = 0; i < cellCount; i++)
+		volume += grid->depth[i];
+	return volume;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef PIPES_H_ /* Include guard */
+#define PIPES_H_
+
+// Shared by the game and the host benchmark, only uses the standard headers
+#include <stdint.h>
+
+#define PIPES_MAX_SOURCES 4
+// Part of the surface difference added to the flow of a pipe every step, 20.12 fixed point
+#define PIPES_GAIN 1024
+// Flow kept from the previous step, 20.12 fixed point
+#define PIPES_DAMPING 4055
+
+/*
+ * Shallow water solver with virtual pipes between neighbour cells.
+ * Cells are stored row after row, index = y * width + x.
+ * Heights, depths and flows are in 20.12 fixed point, they must stay under 16 (2^16)
+ * so the products with the 20.12 factors do not overflow.
+ * The flows only move water between cells, so the volume only changes with the sources.
+ */
+typedef struct
+{
+    int x;
+    int y;
+    int32_t rate; // Depth added every step, negative for a sink
+} PipesSource;
+
+typedef struct
+{
+    int width;
+    int height;
+    int32_t *terrain; // Ground height
+    int32_t *depth;   // Water depth above the ground, never negative
+    int32_t *flowX;   // Flow from a cell to the cell on its right, negative towards the left
+    int32_t *flowY;   // Flow from a cell to the cell of the next row, negative towards the previous row
+    int32_t *scale;   // Outflow scale of every cell, so a cell never gives more water than it has
+    PipesSource sources[PIPES_MAX_SOURCES];
+    int sourceCount;
+    int64_t addedVolume; // Water added by the sources minus the water removed by the sinks
+} PipesGrid;
+
+int PipesBufferSize(int width, int height);
+void PipesInit(PipesGrid *grid, int width, int height, void *buffer);
+void PipesFillToLevel(PipesGrid *grid, int32_t level);
+int32_t PipesAddWater(PipesGrid *grid, int x, int y, int32_t amount);
+int PipesAddSource(PipesGrid *grid, int x, int y, int32_t rate);
+void PipesClearSources(PipesGrid *grid);
+void PipesStep(PipesGrid *grid);
+int64_t PipesVolume(const PipesGrid *grid);
+
+#endif // PIPES_H_
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "profiler.h"
+
+// Timers 2 and 3 are chained by cpuStartTiming, 0 and 1 are left free
+#define PROFILER_TIMER 2
+
+ProfilerTimer profilerTimers[PROFILER_SECTION_COUNT];
+ProfilerCount profilerCounts[PROFILER_COUNTER_COUNT];
+ProfilerScreenRate profilerScreenRates[PROFILER_SCREEN_COUNT];
+// Timer value at the start of the current screen rate second
+u32 profilerScreenRateStart = 0;
+
+/**
+ * @brief Reset all values and start the hardware timer
+ *
+ */
+void ProfilerInit()
+{
+	memset(profilerTimers, 0, sizeof(profilerTimers));
+	memset(profilerCounts, 0, sizeof(profilerCounts));
+	cpuStartTiming(PROFILER_TIMER);
+	ProfilerResetScreenRates();
+}
+
+/**
+ * @brief Start measuring the screen rates again, when the screens change
+ *
+ */
+void ProfilerResetScreenRates()
+{
+	memset(profilerScreenRates, 0, sizeof(profilerScreenRates));
+	profilerScreenRateStart = cpuGetTiming();
+}
+
+/**
+ * @brief Count the screens drawn during the finished frame, and update their rates every second
+ *
+ */
+static void ProfilerUpdateScreenRates()
+{
+	for (int i = 0; i < PROFILER_SCREEN_COUNT; i++)
+	{
+		// A screen is drawn during a frame if its scene function was timed
+		u32 ticks = profilerTimers[PROFILER_SECTION_TOP_SCREEN + i].ticks;
+		if (ticks == 0)
+			continue;
+		profilerScreenRates[i].frames++;
+		profilerScreenRates[i].ticks += ticks;
+	}
+
+	u32 elapsed = cpuGetTiming() - profilerScreenRateStart;
+	if (elapsed < BUS_CLOCK)
+		return;
+
+	for (int i = 0; i < PROFILER_SCREEN_COUNT; i++)
+	{
+		ProfilerScreenRate *rate = &profilerScreenRates[i];
+		rate->fps = ((u64)rate->frames * BUS_CLOCK + elapsed / 2) / elapsed;
+		rate->cpuPercent = (u64)rate->ticks * 100 / elapsed;
+		rate->frameTicks = rate->frames ? rate->ticks / rate->frames : 0;
+		rate->frames = 0;
+		rate->ticks = 0;
+	}
+	profilerScreenRateStart += elapsed;
+}
+
+/**
+ * @brief Start timing a section
+ *
+ * @param section
+ */
+void ProfilerBegin(ProfilerSection section)
+{
+	profilerTimers[section].start = cpuGetTiming();
+}
+
+/**
+ * @brief Stop timing a section, a section can be timed several times per frame
+ *
+ * @param section
+ */
+void ProfilerEnd(ProfilerSection section)
+{
+	ProfilerTimer *timer = &profilerTimers[section];
+	timer->ticks += cpuGetTiming() - timer->start;
+}
+
+/**
+ * @brief Add a value to a counter of the current frame
+ *
+ * @param counter
+ * @param amount
+ */
+void ProfilerAddCount(ProfilerCounter counter, int amount)
+{
+	profilerCounts[counter].value += amount;
+}
+
+/**
+ * @brief Store the values of the finished frame and reset them for the next one
+ *
+ */
+void ProfilerNextFrame()
+{
+	ProfilerUpdateScreenRates();
+
+	for (int i = 0; i < PROFILER_SECTION_COUNT; i++)
+	{
+		ProfilerTimer *timer = &profilerTimers[i];
+		timer->lastTicks = timer->ticks;
+		if (timer->ticks > timer->maxTicks)
+			timer->maxTicks = timer->ticks;
+		timer->ticks = 0;
+	}
+
+	for (int i = 0; i < PROFILER_COUNTER_COUNT; i++)
+	{
+		ProfilerCount *count = &profilerCounts[i];
+		count->lastValue = count->value;
+		if (count->value > count->maxValue)
+			count->maxValue = count->value;
+		count->value = 0;
+	}
+}
+
+/**
+ * @brief Convert timer ticks to microseconds
+ *
+ * @param ticks
+ * @return int
+ */
+int ProfilerTicksToMicroseconds(u32 ticks)
+{
+	return (u64)ticks * 1000000 / BUS_CLOCK;
+}
@@ -0,0 +1,67 @@
+#ifndef PROFILER_H_ /* Include guard */
+#define PROFILER_H_
+
+#include <NEMain.h>
+
+// Timed parts of a frame
+typedef enum
+{
+    PROFILER_SECTION_FRAME, // Whole NE_Process call
+    PROFILER_SECTION_UPDATE_WATER,
+    PROFILER_SECTION_DRAW,
+    PROFILER_SECTION_CHUNK_GENERATION, // Sand chunks generated on a cache miss
+    PROFILER_SECTION_TEXTURE_LOAD,     // Texture upload at boot, in the first frame
+    PROFILER_SECTION_TOP_SCREEN,       // Scene function of the top screen, the only one in single screen mode
+    PROFILER_SECTION_BOTTOM_SCREEN,    // Scene function of the bottom screen, every other frame in dual screen mode
+    PROFILER_SECTION_COUNT
+} ProfilerSection;
+
+// Screens timed by PROFILER_SECTION_TOP_SCREEN and PROFILER_SECTION_BOTTOM_SCREEN
+#define PROFILER_SCREEN_COUNT 2
+
+// Values counted during a frame
+typedef enum
+{
+    PROFILER_COUNTER_NOISE_SAMPLES,    // noise2 calls done by the fBm octaves
+    PROFILER_COUNTER_SIMULATION_STEPS, // Simulation steps run before rendering
+    PROFILER_COUNTER_COUNT
+} ProfilerCounter;
+
+typedef struct
+{
+    u32 start;     // Timer value at ProfilerBegin
+    u32 ticks;     // Ticks spent during the current frame
+    u32 lastTicks; // Ticks spent during the last finished frame
+    u32 maxTicks;  // Highest frame value since the init
+} ProfilerTimer;
+
+typedef struct
+{
+    int value;     // Count for the current frame
+    int lastValue; // Count for the last finished frame
+    int maxValue;  // Highest frame value since the init
+} ProfilerCount;
+
+// Frame rate and CPU use of a screen, measured over about a second
+typedef struct
+{
+    int frames;     // Frames drawn during the current second
+    u32 ticks;      // Ticks spent drawing them
+    int fps;        // Frames drawn during the last second
+    int cpuPercent; // Share of the last second spent drawing them
+    u32 frameTicks; // Mean ticks per frame drawn during the last second
+} ProfilerScreenRate;
+
+extern ProfilerTimer profilerTimers[PROFILER_SECTION_COUNT];
+extern ProfilerCount profilerCounts[PROFILER_COUNTER_COUNT];
+extern ProfilerScreenRate profilerScreenRates[PROFILER_SCREEN_COUNT];
+
+void ProfilerInit();
+void ProfilerBegin(ProfilerSection section);
+void ProfilerEnd(ProfilerSection section);
+void ProfilerAddCount(ProfilerCounter counter, int amount);
+void ProfilerNextFrame();
+void ProfilerResetScreenRates();
+int ProfilerTicksToMicroseconds(u32 ticks);
+
+#endif // PROFILER_H_
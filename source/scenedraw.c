@@ -0,0 +1,342 @@
+#include "scenedraw.h"
+#include "particles.h"
+#include <stddef.h>
+
+#define CAUSTICS_ALPHA 20
+// Not the sand polygon ID, and not the water one so the water is still drawn over the caustics
+#define CAUSTICS_POLYGON_ID 1
+#define SPRAY_ALPHA 22
+#define SPRAY_POLYGON_ID 2
+
+#define CUBE_VERTEX_COUNT 72 / 3
+#define COLOR_WHITE RGB15(31, 31, 31)
+
+// Cube vertices
+const int cubeVert[72] = {
+	-1, 1, 1, // 0
+	-1, -1, 1,
+	1, -1, 1,
+	1, 1, 1,
+	1, 1, -1, // 1
+	1, -1, -1,
+	-1, -1, -1,
+	-1, 1, -1,
+	1, 1, 1, // 2
+	1, -1, 1,
+	1, -1, -1,
+	1, 1, -1,
+	-1, 1, -1, // 3
+	-1, -1, -1,
+	-1, -1, 1,
+	-1, 1, 1,
+	1, 1, 1, // 4
+	1, 1, -1,
+	-1, 1, -1,
+	-1, 1, 1,
+	-1, -1, 1, // 5
+	-1, -1, -1,
+	1, -1, -1,
+	1, -1, 1};
+
+// Cube uvs
+const uint32_t cubeUv[] = {
+	TEXTURE_PACK(inttot16(0), inttot16(55)), // 0
+	TEXTURE_PACK(inttot16(0), inttot16(0)),
+	TEXTURE_PACK(inttot16(55), inttot16(0)),
+	TEXTURE_PACK(inttot16(55), inttot16(55)),
+	TEXTURE_PACK(inttot16(55), inttot16(55)), // 1
+	TEXTURE_PACK(inttot16(55), inttot16(0)),
+	TEXTURE_PACK(inttot16(0), inttot16(0)),
+	TEXTURE_PACK(inttot16(0), inttot16(55)),
+	TEXTURE_PACK(inttot16(55), inttot16(55)), // 2
+	TEXTURE_PACK(inttot16(0), inttot16(55)),
+	TEXTURE_PACK(inttot16(0), inttot16(0)),
+	TEXTURE_PACK(inttot16(55), inttot16(0)),
+	TEXTURE_PACK(inttot16(55), inttot16(0)), // 3
+	TEXTURE_PACK(inttot16(0), inttot16(0)),
+	TEXTURE_PACK(inttot16(0), inttot16(55)),
+	TEXTURE_PACK(inttot16(55), inttot16(55)),
+	TEXTURE_PACK(inttot16(55), inttot16(55)), // 4
+	TEXTURE_PACK(inttot16(55), inttot16(0)),
+	TEXTURE_PACK(inttot16(0), inttot16(0)),
+	TEXTURE_PACK(inttot16(0), inttot16(55)),
+	TEXTURE_PACK(inttot16(0), inttot16(55)), // 5
+	TEXTURE_PACK(inttot16(0), inttot16(0)),
+	TEXTURE_PACK(inttot16(55), inttot16(0)),
+	TEXTURE_PACK(inttot16(55), inttot16(55)),
+};
+
+// Position of a grid point on x or z in the scaled sand space, the points are 2 world units apart
+#define SAND_POSITION(index) (inttov16((index) * 2 + 1) >> SCENE_SAND_SCALE_SHIFT)
+
+/**
+ * @brief Build the display list of the sand tiles, it only changes with the sand and the mesh
+ *
+ * The vertices are in world positions so the tiles need no matrix, both screens call the same list
+ *
+ * @param scene Sand and mesh to use
+ * @param list Receives at most SCENE_SAND_LIST_WORDS words
+ * @return int Number of words written, like glCallList expects them
+ */
+int SceneBuildSandList(const SceneDrawState *scene, uint32_t *list)
+{
+	const uint32_t header = GX_PACK(GX_CMD_TEXCOORD, GX_CMD_VTX_16, GX_CMD_TEXCOORD, GX_CMD_VTX_16);
+	uint32_t *word = list + 1;
+	for (int i = 1; i < scene->meshIndexCount; i++)
+	{
+		int x0 = scene->meshIndices[i - 1];
+		int x = scene->meshIndices[i];
+		uint32_t left = SAND_POSITION(x0) & 0xFFFF;
+		uint32_t right = SAND_POSITION(x) & 0xFFFF;
+		for (int j = 1; j < scene->meshIndexCount; j++)
+		{
+			int y0 = scene->meshIndices[j - 1];
+			int y = scene->meshIndices[j];
+			uint32_t near = SAND_POSITION(y0) & 0xFFFF;
+			uint32_t far = SAND_POSITION(y) & 0xFFFF;
+
+			*word++ = header;
+			*word++ = TEXTURE_PACK(inttot16(127), inttot16(127));
+			*word++ = (uint32_t)scene->sand[x][y].intHeight << 16 | right;
+			*word++ = far;
+			*word++ = TEXTURE_PACK(inttot16(127), inttot16(0));
+			*word++ = (uint32_t)scene->sand[x][y0].intHeight << 16 | right;
+			*word++ = near;
+
+			*word++ = header;
+			*word++ = TEXTURE_PACK(inttot16(0), inttot16(0));
+			*word++ = (uint32_t)scene->sand[x0][y0].intHeight << 16 | left;
+			*word++ = near;
+			*word++ = TEXTURE_PACK(inttot16(0), inttot16(127));
+			*word++ = (uint32_t)scene->sand[x0][y].intHeight << 16 | left;
+			*word++ = far;
+		}
+	}
+
+	list[0] = word - list - 1;
+	return word - list;
+}
+
+/**
+ * @brief Draw sand ground
+ *
+ * @param scene
+ */
+void DrawSand(const SceneDrawState *scene)
+{
+	GxPolyFormat(31, 0, GX_LIGHT_0, GX_CULL_NONE, GX_MODULATION);
+	GxBegin(GX_QUADS);
+	GxMaterialUse(scene->sandMaterial);
+
+	// Create a plane under the sand to hide artefacts due to float precision
+	GxPushMatrix();
+	GxTranslate(inttov16(WATER_SIZE + 1), inttov16(-2), inttov16(WATER_SIZE + 1));
+	GxScale(inttov16(WATER_SIZE + 1), inttov16(1), inttov16(WATER_SIZE + 1));
+	GxTexCoord(TEXTURE_PACK(inttot16(127), inttot16(127)));
+	GxVertex16(inttov16(1), 0, inttov16(1));
+	GxTexCoord(TEXTURE_PACK(inttot16(127), inttot16(0)));
+	GxVertex16(inttov16(1), 0, inttov16(-1));
+	GxTexCoord(TEXTURE_PACK(inttot16(0), inttot16(0)));
+	GxVertex16(inttov16(-1), 0, inttov16(-1));
+	GxTexCoord(TEXTURE_PACK(inttot16(0), inttot16(127)));
+	GxVertex16(inttov16(-1), 0, inttov16(1));
+	GxPopMatrix(1);
+
+	// Draw sand tiles
+	GxPushMatrix();
+	GxScale(inttof32(1 << SCENE_SAND_SCALE_SHIFT), SAND_HEIGHT_INT, inttof32(1 << SCENE_SAND_SCALE_SHIFT));
+	GxCallList(scene->sandList);
+	GxPopMatrix(1);
+
+	GxEnd();
+}
+
+/**
+ * @brief Draw the caustics over the sand, only the texture offset changes between frames
+ *
+ * @param scene
+ */
+void DrawCaustics(const SceneDrawState *scene)
+{
+	// Same vertices and matrix as the sand, so only the pixels of the sand pass the equal depth test
+	GxPolyFormat(CAUSTICS_ALPHA, CAUSTICS_POLYGON_ID, GX_LIGHT_0, GX_CULL_NONE, GX_MODULATION | GX_DEPTH_TEST_EQUAL);
+	GxBegin(GX_QUADS);
+	GxMaterialUse(scene->causticsMaterial);
+
+	GxPushMatrix();
+	GxScale(inttof32(1 << SCENE_SAND_SCALE_SHIFT), SAND_HEIGHT_INT, inttof32(1 << SCENE_SAND_SCALE_SHIFT));
+	for (int i = 1; i < scene->meshIndexCount; i++)
+	{
+		int x0 = scene->meshIndices[i - 1];
+		int x = scene->meshIndices[i];
+		int left = SAND_POSITION(x0);
+		int right = SAND_POSITION(x);
+		// Texture coordinates follow the world so the pattern does not jump when the grid moves
+		int u0 = ((scene->worldX + x0) * inttot16(CAUSTICS_CELL_TEXELS) + scene->causticsU) & CAUSTICS_UV_MASK;
+		int u = u0 + (x - x0) * inttot16(CAUSTICS_CELL_TEXELS);
+		for (int j = 1; j < scene->meshIndexCount; j++)
+		{
+			int y0 = scene->meshIndices[j - 1];
+			int y = scene->meshIndices[j];
+			int near = SAND_POSITION(y0);
+			int far = SAND_POSITION(y);
+			int v0 = ((scene->worldY + y0) * inttot16(CAUSTICS_CELL_TEXELS) + scene->causticsV) & CAUSTICS_UV_MASK;
+			int v = v0 + (y - y0) * inttot16(CAUSTICS_CELL_TEXELS);
+
+			GxColor(scene->sand[x][y].causticsColor);
+			GxTexCoord(TEXTURE_PACK(u, v));
+			GxVertex16(right, scene->sand[x][y].intHeight, far);
+
+			GxColor(scene->sand[x][y0].causticsColor);
+			GxTexCoord(TEXTURE_PACK(u, v0));
+			GxVertex16(right, scene->sand[x][y0].intHeight, near);
+
+			GxColor(scene->sand[x0][y0].causticsColor);
+			GxTexCoord(TEXTURE_PACK(u0, v0));
+			GxVertex16(left, scene->sand[x0][y0].intHeight, near);
+
+			GxColor(scene->sand[x0][y].causticsColor);
+			GxTexCoord(TEXTURE_PACK(u0, v));
+			GxVertex16(left, scene->sand[x0][y].intHeight, far);
+		}
+	}
+	GxPopMatrix(1);
+
+	GxEnd();
+}
+
+/**
+ * @brief Draw the spray as one display list of quads facing the camera
+ *
+ * The list is built by the caller, the quads face the camera
+ *
+ * @param scene
+ */
+void DrawSpray(const SceneDrawState *scene)
+{
+	if (!scene->sprayList)
+		return;
+
+	GxPolyFormat(SPRAY_ALPHA, SPRAY_POLYGON_ID, GX_LIGHT_0, GX_CULL_NONE, GX_MODULATION);
+	GxBegin(GX_QUADS);
+	GxMaterialUse(NULL);
+
+	GxPushMatrix();
+	GxScale(inttof32(1 << PARTICLES_DRAW_SCALE_SHIFT), inttof32(1 << PARTICLES_DRAW_SCALE_SHIFT), inttof32(1 << PARTICLES_DRAW_SCALE_SHIFT));
+	GxCallList(scene->sprayList);
+	GxPopMatrix(1);
+
+	GxEnd();
+}
+
+/**
+ * @brief Draw the water tiles, sky is a constant in both calls so the test is compiled out
+ *
+ * @param scene
+ * @param sky Send the sky texture coordinates of the points
+ */
+static inline __attribute__((always_inline)) void DrawWaterTiles(const SceneDrawState *scene, const bool sky)
+{
+	GxPushMatrix();
+	GxScale(inttov16(1), WAVE_HEIGHT_INT, inttov16(1));
+	for (int i = 1; i < scene->meshIndexCount; i++)
+	{
+		int x0 = scene->meshIndices[i - 1];
+		int x = scene->meshIndices[i];
+		int sizeX = inttov16(x - x0);
+		for (int j = 1; j < scene->meshIndexCount; j++)
+		{
+			int y0 = scene->meshIndices[j - 1];
+			int y = scene->meshIndices[j];
+			int sizeY = inttov16(y - y0);
+			GxPushMatrix();
+			GxTranslate(inttov16(x + x0 + 1), inttov16(0), inttov16(y + y0 + 1));
+
+			WaterPoint *point = &scene->water[x][y];
+			GxColor(point->color);
+			if (sky)
+				GxTexCoord(point->skyUv);
+			GxVertex16(sizeX + point->renderXOffset, point->renderHeight, sizeY + point->renderZOffset);
+
+			point = &scene->water[x][y0];
+			GxColor(point->color);
+			if (sky)
+				GxTexCoord(point->skyUv);
+			GxVertex16(sizeX + point->renderXOffset, point->renderHeight, -sizeY + point->renderZOffset);
+
+			point = &scene->water[x0][y0];
+			GxColor(point->color);
+			if (sky)
+				GxTexCoord(point->skyUv);
+			GxVertex16(-sizeX + point->renderXOffset, point->renderHeight, -sizeY + point->renderZOffset);
+
+			point = &scene->water[x0][y];
+			GxColor(point->color);
+			if (sky)
+				GxTexCoord(point->skyUv);
+			GxVertex16(-sizeX + point->renderXOffset, point->renderHeight, sizeY + point->renderZOffset);
+
+			GxPopMatrix(1);
+		}
+	}
+	GxPopMatrix(1);
+}
+
+/**
+ * @brief Draw animated water
+ *
+ * @param scene
+ */
+void DrawWater(const SceneDrawState *scene)
+{
+	// Set water transparency
+	if (scene->style == WATER_STYLE_CLEAR)
+		GxPolyFormat(15, 0, GX_LIGHT_0, GX_CULL_NONE, GX_MODULATION);
+	else
+		GxPolyFormat(25, 0, GX_LIGHT_0, GX_CULL_NONE, GX_MODULATION);
+
+	GxBegin(GX_QUADS);
+	if (scene->style == WATER_STYLE_SKY)
+	{
+		// The sky texture is modulated by the light colors of the style
+		GxMaterialUse(scene->skyMaterial);
+		DrawWaterTiles(scene, true);
+	}
+	else
+	{
+		// Do not use a texture for the wayer
+		GxMaterialUse(NULL);
+		DrawWaterTiles(scene, false);
+	}
+
+	GxEnd();
+}
+
+/**
+ * @brief Draw floating cube
+ *
+ * @param scene
+ */
+void DrawCube(const SceneDrawState *scene)
+{
+	GxPolyFormat(31, 0, GX_LIGHT_0, GX_CULL_BACK, GX_MODULATION);
+	GxBegin(GX_QUADS);
+	GxMaterialUse(scene->cubeMaterial);
+
+	GxColor(COLOR_WHITE); // Set next vertices color
+
+	//  Set cube position
+	GxPushMatrix();
+	GxTranslate(scene->cubeX, scene->cubeY, scene->cubeZ);
+
+	// Draw all vertex
+	for (int vI = 0; vI < CUBE_VERTEX_COUNT; vI++)
+	{
+		GxTexCoord(cubeUv[vI]);
+		int offset = vI * 3;
+		GxVertex16(inttov16(cubeVert[offset]), inttov16(cubeVert[offset + 1]), inttov16(cubeVert[offset + 2]));
+	}
+	GxPopMatrix(1);
+
+	GxEnd();
+}
@@ -0,0 +1,48 @@
+#ifndef SCENEDRAW_H_ /* Include guard */
+#define SCENEDRAW_H_
+
+// Draw paths of the scene, shared by the game and the host recorder tool through gx.h
+#include "water.h"
+#include "gx.h"
+
+// Caustics texture size and texels covered by a grid cell, the pattern repeats every 4 cells
+#define CAUSTICS_TEXTURE_SIZE 64
+#define CAUSTICS_CELL_TEXELS 16
+#define CAUSTICS_UV_MASK (inttot16(CAUSTICS_TEXTURE_SIZE) - 1)
+
+// Log2 of the world units per v16 unit of the sand and caustics vertices, so the whole grid fits in v16
+#define SCENE_SAND_SCALE_SHIFT 2
+// Words of the sand display list of the full mesh: the word count, then 2 headers and 12 parameters per tile
+#define SCENE_SAND_LIST_WORDS (1 + (WATER_SIZE - 1) * (WATER_SIZE - 1) * 14)
+
+// Inputs of the draw paths, set by Draw3DScene every frame
+typedef struct
+{
+    WaterPoint (*water)[WATER_SIZE];
+    SandPoint (*sand)[WATER_SIZE];
+    const int *meshIndices;   // Point indices used as mesh vertices
+    int meshIndexCount;
+    int worldX;               // World cell of the first point
+    int worldY;
+    int causticsU;            // Caustics texture offset in 1/16 texel
+    int causticsV;
+    WaterStyle style;
+    int32_t cubeX;            // Cube position in 20.12 fixed point
+    int32_t cubeY;
+    int32_t cubeZ;
+    const uint32_t *sprayList; // Display list of the spray, NULL when there is no particle
+    const uint32_t *sandList;  // Display list of the sand tiles, built by SceneBuildSandList
+    GxMaterial *sandMaterial;
+    GxMaterial *causticsMaterial;
+    GxMaterial *cubeMaterial;
+    GxMaterial *skyMaterial;
+} SceneDrawState;
+
+int SceneBuildSandList(const SceneDrawState *scene, uint32_t *list);
+void DrawSand(const SceneDrawState *scene);
+void DrawCaustics(const SceneDrawState *scene);
+void DrawWater(const SceneDrawState *scene);
+void DrawSpray(const SceneDrawState *scene);
+void DrawCube(const SceneDrawState *scene);
+
+#endif // SCENEDRAW_H_
@@ -0,0 +1,88 @@
+#include "simclock.h"
+
+// Simulation steps per second, a divisor of SIM_CLOCK_SOURCE_HZ
+int simClockStepHz = SIM_CLOCK_SOURCE_HZ;
+// Source ticks (60 Hz frames) simulated by one step
+int simClockStepFrames = 1;
+// Position between the last two steps for rendering, 20.12 fixed point
+int simClockAlpha = 0;
+
+// Source ticks counted by the VBlank interrupt
+volatile uint32_t simClockTicks = 0;
+// Last source tick value read by SimClockAdvance
+uint32_t simClockLastTicks = 0;
+// Source ticks not simulated yet
+int simClockAccumulator = 0;
+
+/**
+ * @brief Get the current time in source ticks, the host tools call SimClockVBlank themselves
+ *
+ * @return uint32_t
+ */
+static uint32_t SimClockNow()
+{
+	return simClockTicks;
+}
+
+/**
+ * @brief Start the clock
+ *
+ * @param stepHz Simulation steps per second
+ */
+void SimClockInit(int stepHz)
+{
+	SimClockSetRate(stepHz);
+	simClockLastTicks = SimClockNow();
+	simClockAccumulator = 0;
+	simClockAlpha = 0;
+}
+
+/**
+ * @brief Change the simulation rate, the motion speed stays the same
+ *
+ * @param stepHz Simulation steps per second, rounded to a divisor of SIM_CLOCK_SOURCE_HZ
+ */
+void SimClockSetRate(int stepHz)
+{
+	if (stepHz < 1)
+		stepHz = 1;
+	else if (stepHz > SIM_CLOCK_SOURCE_HZ)
+		stepHz = SIM_CLOCK_SOURCE_HZ;
+
+	simClockStepFrames = SIM_CLOCK_SOURCE_HZ / stepHz;
+	simClockStepHz = SIM_CLOCK_SOURCE_HZ / simClockStepFrames;
+	if (simClockAccumulator > simClockStepFrames)
+		simClockAccumulator = simClockStepFrames;
+}
+
+/**
+ * @brief Count a VBlank, called from the VBlank interrupt
+ *
+ */
+void SimClockVBlank()
+{
+	simClockTicks++;
+}
+
+/**
+ * @brief Add the time since the last call and get the number of steps to simulate before rendering
+ *
+ * @return int Steps from 0 to SIM_CLOCK_MAX_STEPS, simClockAlpha is updated for the interpolation
+ */
+int SimClockAdvance()
+{
+	uint32_t now = SimClockNow();
+	simClockAccumulator += now - simClockLastTicks;
+	simClockLastTicks = now;
+
+	int steps = simClockAccumulator / simClockStepFrames;
+	simClockAccumulator -= steps * simClockStepFrames;
+	if (steps > SIM_CLOCK_MAX_STEPS)
+	{
+		// Too far behind, drop time instead of spending even more frames catching up
+		steps = SIM_CLOCK_MAX_STEPS;
+	}
+
+	simClockAlpha = simClockAccumulator * 4096 / simClockStepFrames;
+	return steps;
+}
@@ -0,0 +1,21 @@
+#ifndef SIMCLOCK_H_ /* Include guard */
+#define SIMCLOCK_H_
+
+// Shared by the game and the host check, only uses the standard headers
+#include <stdint.h>
+
+// Rate of the time source (VBlank)
+#define SIM_CLOCK_SOURCE_HZ 60
+// Maximum simulation steps per rendered frame, extra time is dropped
+#define SIM_CLOCK_MAX_STEPS 4
+
+extern int simClockStepHz;
+extern int simClockStepFrames;
+extern int simClockAlpha;
+
+void SimClockInit(int stepHz);
+void SimClockSetRate(int stepHz);
+void SimClockVBlank();
+int SimClockAdvance();
+
+#endif // SIMCLOCK_H_
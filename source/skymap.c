@@ -0,0 +1,100 @@
+#include "skymap.h"
+#include "trig.h"
+#include <math.h>
+
+// Pitch of the camera, 12 units above the grid and 14 units away from its middle
+#define SKY_VIEW_PITCH 0.709f
+// A height difference over two cells (4 world units) is a slope of delta * WAVE_HEIGHT / (4 * 4096),
+// the table index is slope * SKY_SLOPE_LEVELS / 2 + SKY_SLOPE_LEVELS / 2
+#define SKY_SLOPE_SCALE (WAVE_HEIGHT * SKY_SLOPE_LEVELS)
+#define SKY_SLOPE_SHIFT 15
+#define SKY_PI 3.14159265f
+
+/**
+ * @brief Fill the normal to texture coordinates table, run once at init
+ *
+ * Every entry reflects the view direction on the normal of a slope, and gives the point of the sky texture seen in that direction.
+ * The slopes are in view space: x to the right of the camera and z away from it
+ *
+ * @param table SKY_TABLE_SIZE packed texture coordinates, indexed by slope on x then slope on z
+ */
+void SkyMapBuildTable(uint32_t *table)
+{
+	const float viewY = -sinf(SKY_VIEW_PITCH);
+	const float viewZ = cosf(SKY_VIEW_PITCH);
+	const float radius = SKY_TEXTURE_SIZE / 2 - 1;
+	for (int i = 0; i < SKY_SLOPE_LEVELS; i++)
+	{
+		float slopeX = (i + 0.5f) * 2 / SKY_SLOPE_LEVELS - 1;
+		for (int j = 0; j < SKY_SLOPE_LEVELS; j++)
+		{
+			float slopeZ = (j + 0.5f) * 2 / SKY_SLOPE_LEVELS - 1;
+			float length = sqrtf(slopeX * slopeX + 1 + slopeZ * slopeZ);
+			float normalX = -slopeX / length;
+			float normalY = 1 / length;
+			float normalZ = -slopeZ / length;
+
+			// Reflected view direction
+			float dot = viewY * normalY + viewZ * normalZ;
+			float reflectX = -2 * dot * normalX;
+			float reflectY = viewY - 2 * dot * normalY;
+			float reflectZ = viewZ - 2 * dot * normalZ;
+
+			// Elevation of the reflection, directions under the horizon see the horizon
+			float elevation = reflectY > 0 ? asinf(reflectY < 1 ? reflectY : 1) : 0;
+			float azimuth = atan2f(reflectX, reflectZ);
+			float distance = (1 - elevation * 2 / SKY_PI) * radius;
+			int u = (SKY_TEXTURE_SIZE / 2 + distance * sinf(azimuth)) * 16;
+			int v = (SKY_TEXTURE_SIZE / 2 + distance * cosf(azimuth)) * 16;
+			table[i * SKY_SLOPE_LEVELS + j] = (uint32_t)u | ((uint32_t)v << 16);
+		}
+	}
+}
+
+/**
+ * @brief Get the table index of a height difference over two cells
+ *
+ * @param delta
+ * @return int
+ */
+static inline int SkySlopeIndex(int delta)
+{
+	int index = ((delta * SKY_SLOPE_SCALE) >> SKY_SLOPE_SHIFT) + SKY_SLOPE_LEVELS / 2;
+	if (index < 0)
+		return 0;
+	if (index >= SKY_SLOPE_LEVELS)
+		return SKY_SLOPE_LEVELS - 1;
+	return index;
+}
+
+/**
+ * @brief Set the sky texture coordinates of every point from the slope of the rendered surface
+ *
+ * @param water
+ * @param table Filled by SkyMapBuildTable
+ * @param viewAngle Camera angle in binary angle units, the camera looks along (sin, cos) in grid space
+ */
+void SkyMapUpdate(WaterPoint (*water)[WATER_SIZE], const uint32_t *table, int viewAngle)
+{
+	// The slopes are rotated from grid space to the view space of the table
+	int sine = TrigSin(viewAngle);
+	int cosine = TrigCos(viewAngle);
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		// Differences over one cell on the edges are doubled
+		const WaterPoint *previousRow = water[x > 0 ? x - 1 : x];
+		const WaterPoint *nextRow = water[x < WATER_SIZE - 1 ? x + 1 : x];
+		int rowScale = x > 0 && x < WATER_SIZE - 1 ? 1 : 2;
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			int previousY = y > 0 ? y - 1 : y;
+			int nextY = y < WATER_SIZE - 1 ? y + 1 : y;
+			int columnScale = y > 0 && y < WATER_SIZE - 1 ? 1 : 2;
+			int deltaX = (nextRow[y].renderHeight - previousRow[y].renderHeight) * rowScale;
+			int deltaZ = (water[x][nextY].renderHeight - water[x][previousY].renderHeight) * columnScale;
+			int viewX = (deltaX * cosine - deltaZ * sine) >> 12;
+			int viewZ = (deltaX * sine + deltaZ * cosine) >> 12;
+			water[x][y].skyUv = table[SkySlopeIndex(viewX) * SKY_SLOPE_LEVELS + SkySlopeIndex(viewZ)];
+		}
+	}
+}
@@ -0,0 +1,16 @@
+#ifndef SKYMAP_H_ /* Include guard */
+#define SKYMAP_H_
+
+// Shared by the game and the host tools, only uses the standard headers
+#include "water.h"
+
+// The sky texture is a polar view of the sky dome: zenith in the middle, horizon on the edge
+#define SKY_TEXTURE_SIZE 64
+// Slope levels on each axis of the normal to texture coordinates table, for slopes from -1 to 1
+#define SKY_SLOPE_LEVELS 32
+#define SKY_TABLE_SIZE (SKY_SLOPE_LEVELS * SKY_SLOPE_LEVELS)
+
+void SkyMapBuildTable(uint32_t *table);
+void SkyMapUpdate(WaterPoint (*water)[WATER_SIZE], const uint32_t *table, int viewAngle);
+
+#endif // SKYMAP_H_
@@ -0,0 +1,21 @@
+#ifndef TRIG_H_ /* Include guard */
+#define TRIG_H_
+
+// Shared by the game and the host tools, only uses the standard headers
+#include <stdint.h>
+
+// Angles are in binary angle units: a full turn is 65536, so any int can be
+// used as an angle and wraps for free
+#define TRIG_ANGLE_FULL 65536
+#define TRIG_ANGLE_HALF (TRIG_ANGLE_FULL / 2)
+#define TRIG_ANGLE_QUARTER (TRIG_ANGLE_FULL / 4)
+
+// Results are in 20.12 fixed point like f32 (4096 = 1.0)
+#define TRIG_ONE 4096
+
+int TrigSin(int angle);
+int TrigCos(int angle);
+int TrigSinLerp(int angle);
+int TrigCosLerp(int angle);
+
+#endif // TRIG_H_
@@ -0,0 +1,60 @@
+#ifndef WATER_H_ /* Include guard */
+#define WATER_H_
+
+// Water grid types, shared by the game and the host tools, only uses the standard headers
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+    float height;
+    int intHeight;
+    int finalHeight;
+    int previousHeight; // finalHeight before the last simulation step
+    int renderHeight;   // Height interpolated between the last two simulation steps
+    int xOffset;         // Horizontal displacement on x (v16)
+    int zOffset;         // Horizontal displacement on z (v16)
+    int previousXOffset; // xOffset before the last simulation step
+    int previousZOffset; // zOffset before the last simulation step
+    int renderXOffset;   // Displacements interpolated between the last two simulation steps
+    int renderZOffset;
+    uint32_t color;
+    uint32_t skyUv;     // Sky texture coordinates of the reflection style, packed like TEXTURE_PACK
+} WaterPoint;
+
+typedef struct
+{
+    float height;
+    int intHeight;
+    uint32_t causticsColor; // Caustics tint for the water depth above this point
+} SandPoint;
+
+#define WATER_SIZE 14 // EVEN NUMBER ONLY
+// World heights of a water or sand height of 1.0
+#define WAVE_HEIGHT 6
+#define SAND_HEIGHT 3
+#define WAVE_HEIGHT_INT (WAVE_HEIGHT * 4096)
+#define SAND_HEIGHT_INT (SAND_HEIGHT * 4096)
+
+typedef enum
+{
+    WATER_MODE_PERLIN,   // Perlin noise on every point
+    WATER_MODE_FAST,     // Interpolation from static noise values
+    WATER_MODE_GERSTNER, // Sum of Gerstner waves
+    WATER_MODE_FBM,      // Several cached noise octaves
+    WATER_MODE_PLAYBACK, // Precomputed animation streamed from NitroFS
+    WATER_MODE_PIPES,    // Shallow water flowing over the sand
+    WATER_MODE_SIMPLEX,  // Simplex noise with the time as the third dimension
+    WATER_MODE_FLOW,     // Simplex noise moved along currents baked from the sand
+    WATER_MODE_COUNT
+} WaterMode;
+
+typedef enum
+{
+    WATER_STYLE_OPAQUE,
+    WATER_STYLE_CLEAR,
+    WATER_STYLE_SKY,    // Opaque water reflecting the sky texture
+    WATER_STYLE_COUNT
+} WaterStyle;
+
+#endif // WATER_H_
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "wateranim.h"
+#include "animcodec.h"
+#include "draw3d.h"
+#include "arena.h"
+
+typedef struct
+{
+	u8 *data;  // Coded frame
+	int size;  // Size of the coded frame
+	int frame; // Index of the frame in the animation
+} WaterAnimSlot;
+
+FILE *animFile = NULL;
+AnimHeader animHeader;
+// Frame offsets in the file, frameCount + 1 entries
+u32 *animOffsets = NULL;
+
+// Ring of frames read ahead
+WaterAnimSlot animRing[WATER_ANIM_RING_SIZE];
+int animRingHead = 0;
+int animRingCount = 0;
+// Next frame to read from the file
+int animReadFrame = 0;
+// Position of the file after the last read, to avoid seeking
+int animFilePosition = -1;
+
+// Decoded grid
+s16 animHeights[WATER_SIZE * WATER_SIZE];
+u16 animColors[WATER_SIZE * WATER_SIZE];
+// 60 Hz frames not played yet
+int animPendingFrames = 0;
+
+/**
+ * @brief Open an animation file and read its frame index
+ *
+ * @param path
+ * @return true if the animation can be played on the water grid
+ */
+bool WaterAnimOpen(const char *path)
+{
+	WaterAnimClose();
+
+	animFile = fopen(path, "rb");
+	if (!animFile)
+		return false;
+
+	if (fread(&animHeader, sizeof(animHeader), 1, animFile) != 1 ||
+		animHeader.magic != ANIM_MAGIC || animHeader.version != ANIM_VERSION ||
+		animHeader.width != WATER_SIZE || animHeader.height != WATER_SIZE ||
+		animHeader.frameCount == 0 || animHeader.frameStep == 0)
+	{
+		WaterAnimClose();
+		return false;
+	}
+
+	// The buffers come from the arena and stay allocated, the file is only opened once at startup
+	animOffsets = ArenaAlloc(ARENA_WATER_ANIM, (animHeader.frameCount + 1) * sizeof(u32));
+	if (!animOffsets || fread(animOffsets, sizeof(u32), animHeader.frameCount + 1, animFile) != animHeader.frameCount + 1u)
+	{
+		WaterAnimClose();
+		return false;
+	}
+	animFilePosition = ftell(animFile);
+
+	for (int i = 0; i < WATER_ANIM_RING_SIZE; i++)
+	{
+		animRing[i].data = ArenaAlloc(ARENA_WATER_ANIM, animHeader.maxFrameSize);
+		if (!animRing[i].data)
+		{
+			WaterAnimClose();
+			return false;
+		}
+	}
+
+	animRingHead = 0;
+	animRingCount = 0;
+	animReadFrame = 0;
+	animPendingFrames = 0;
+	WaterAnimPrefetch();
+	return true;
+}
+
+/**
+ * @brief Close the animation file, the arena buffers are not given back
+ *
+ */
+void WaterAnimClose()
+{
+	if (animFile)
+		fclose(animFile);
+	animFile = NULL;
+
+	animOffsets = NULL;
+	for (int i = 0; i < WATER_ANIM_RING_SIZE; i++)
+		animRing[i].data = NULL;
+	animRingCount = 0;
+}
+
+/**
+ * @brief Check if an animation is ready to be played
+ *
+ * @return true
+ */
+bool WaterAnimIsOpen()
+{
+	return animFile != NULL;
+}
+
+/**
+ * @brief Read the next coded frame in a free slot of the ring
+ *
+ * @return true if a frame was read
+ */
+bool WaterAnimReadNext()
+{
+	if (animRingCount == WATER_ANIM_RING_SIZE)
+		return false;
+
+	WaterAnimSlot *slot = &animRing[(animRingHead + animRingCount) % WATER_ANIM_RING_SIZE];
+	int offset = animOffsets[animReadFrame];
+	int size = animOffsets[animReadFrame + 1] - offset;
+	if (size <= 0 || size > (int)animHeader.maxFrameSize)
+		return false;
+
+	// Frames follow each other in the file, a seek is only needed when looping
+	if (animFilePosition != offset && fseek(animFile, offset, SEEK_SET) != 0)
+		return false;
+	if (fread(slot->data, 1, size, animFile) != (size_t)size)
+	{
+		animFilePosition = -1;
+		return false;
+	}
+	animFilePosition = offset + size;
+
+	slot->size = size;
+	slot->frame = animReadFrame;
+	animRingCount++;
+	animReadFrame = (animReadFrame + 1) % animHeader.frameCount;
+	return true;
+}
+
+/**
+ * @brief Fill the free slots of the ring, to call when the CPU is idle
+ *
+ */
+void WaterAnimPrefetch()
+{
+	if (!animFile)
+		return;
+
+	while (WaterAnimReadNext())
+	{
+	}
+}
+
+/**
+ * @brief Decode the next frame of the ring in the animation grid, a corrupt frame stops the playback
+ *
+ * @return true if a frame was decoded
+ */
+bool WaterAnimDecodeNext()
+{
+	// The prefetch did not keep up, read the frame now
+	if (animRingCount == 0 && !WaterAnimReadNext())
+		return false;
+
+	WaterAnimSlot *slot = &animRing[animRingHead];
+	// The first frame is coded from an empty grid
+	if (slot->frame == 0)
+	{
+		memset(animHeights, 0, sizeof(animHeights));
+		memset(animColors, 0, sizeof(animColors));
+	}
+
+	// The next frames are coded from this one, they can't be played either
+	if (AnimDecodeFrame(slot->data, slot->size, WATER_SIZE * WATER_SIZE, animHeights, animColors) != 0)
+	{
+		WaterAnimClose();
+		return false;
+	}
+	animRingHead = (animRingHead + 1) % WATER_ANIM_RING_SIZE;
+	animRingCount--;
+	return true;
+}
+
+/**
+ * @brief Advance the animation and write it in the water grid
+ *
+ * @param frames Number of 60 Hz frames to advance
+ * @param useColors Use the colors of the animation instead of leaving them to the color kernels
+ */
+void WaterAnimUpdate(int frames, bool useColors)
+{
+	if (!animFile)
+		return;
+
+	animPendingFrames += frames;
+	bool decoded = false;
+	while (animPendingFrames >= animHeader.frameStep)
+	{
+		animPendingFrames -= animHeader.frameStep;
+		decoded |= WaterAnimDecodeNext();
+	}
+	// The grid of a frame that failed to decode is not used
+	if (!decoded || !animFile)
+		return;
+
+	const s16 *height = animHeights;
+	const u16 *color = animColors;
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			WaterPoint *point = &water[x][y];
+			point->finalHeight = *height++;
+			if (useColors)
+				point->color = *color;
+			color++;
+		}
+	}
+}
@@ -0,0 +1,17 @@
+#ifndef WATERANIM_H_ /* Include guard */
+#define WATERANIM_H_
+
+// Shared by the game and the host tools, only uses the standard headers
+#include <stdbool.h>
+
+#define WATER_ANIM_PATH "nitro:/water.anim"
+// Coded frames read ahead of the decoder
+#define WATER_ANIM_RING_SIZE 4
+
+bool WaterAnimOpen(const char *path);
+void WaterAnimClose();
+bool WaterAnimIsOpen();
+void WaterAnimPrefetch();
+void WaterAnimUpdate(int frames, bool useColors);
+
+#endif // WATERANIM_H_
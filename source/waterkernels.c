@@ -0,0 +1,250 @@
+#include "waterkernels.h"
+#include "noise.h"
+#include "flowmap.h"
+#include <stddef.h>
+
+#define WATER_POINT_COUNT (WATER_SIZE * WATER_SIZE)
+// Distance between two points in the simplex noise, its features are smaller than the Perlin noise ones
+#define WATER_SIMPLEX_STEP (4096 / 14)
+// Noise distance travelled in a flow cycle is flow * 2^(12 - WATER_FLOW_DISTANCE_SHIFT), about 2 points at the maximum flow
+#define WATER_FLOW_DISTANCE_SHIFT 9
+// Noise offset of the second phase, so the two samples are not the same pattern
+#define WATER_FLOW_PHASE_OFFSET 2731
+#define WATER_RGB15(r, g, b) ((r) | ((g) << 5) | ((b) << 10))
+
+WaterKernelSet waterKernels;
+
+static inline int KernelLerp(int a, int b, float f)
+{
+	return a * (1 - f) + (b * f);
+}
+
+/**
+ * @brief Set the water color of a point, the flags are constants in every kernel so the tests are compiled out
+ *
+ * @param point
+ * @param sand Sand under the point
+ * @param style
+ * @param floatHeight Use the float height of the Perlin mode instead of finalHeight
+ */
+static inline __attribute__((always_inline)) void WaterColor(WaterPoint *point, const SandPoint *sand, const WaterStyle style, const bool floatHeight)
+{
+	// Get the difference between the height of the sand and the height of the water
+	int heightDiff;
+	if (floatHeight)
+		heightDiff = (point->height * 2 - sand->height) * 200;
+	else
+		heightDiff = (point->finalHeight * 2 - sand->intHeight) * 200 / 4096;
+
+	// Set color intensity of the basic water color
+	int colorIntensity;
+	if (floatHeight)
+		colorIntensity = point->height * 11;
+	else
+		colorIntensity = point->finalHeight / 4096.0f * 11;
+	// Dry shallow water points are under the sand level
+	if (colorIntensity < 0)
+		colorIntensity = 0;
+
+	// If the water is close to the sand
+	if (heightDiff <= 20)
+	{
+		// If the water is under the sand, the value is lower than 0 so put the value to 0
+		if (heightDiff < 0)
+			heightDiff = 0;
+
+		// Ratio for interpolation between the basic water color and the light water color when close to the sand
+		float heightDifRatio = heightDiff / 20.0f;
+		if (style == WATER_STYLE_CLEAR)
+		{
+			int col1 = KernelLerp(20, colorIntensity, heightDifRatio);
+			int col2 = KernelLerp(20, 7 + colorIntensity, heightDifRatio);
+			point->color = WATER_RGB15(col1, col1, col2);
+		}
+		else if (style == WATER_STYLE_SKY)
+		{
+			int col1 = KernelLerp(20, 16 + colorIntensity, heightDifRatio);
+			int col2 = KernelLerp(20, 20 + colorIntensity / 2, heightDifRatio);
+			point->color = WATER_RGB15(col1, col2, 31);
+		}
+		else
+		{
+			int col1 = KernelLerp(20, 5 - colorIntensity / 2, heightDifRatio);
+			int col2 = KernelLerp(20, 11 - colorIntensity, heightDifRatio);
+			int col3 = KernelLerp(31, 31 - colorIntensity, heightDifRatio);
+			point->color = WATER_RGB15(col1, col2, col3);
+		}
+	}
+	else // Basic water color
+	{
+		if (style == WATER_STYLE_CLEAR)
+			point->color = WATER_RGB15(colorIntensity, colorIntensity, 7 + colorIntensity);
+		else if (style == WATER_STYLE_SKY) // Light colors, modulated by the sky texture
+			point->color = WATER_RGB15(16 + colorIntensity, 20 + colorIntensity / 2, 31);
+		else
+			point->color = WATER_RGB15(5 - colorIntensity / 2, 11 - colorIntensity, 31 - colorIntensity);
+	}
+}
+
+// Set every point from noise
+#define WATER_INIT_KERNEL(name, style, floatHeight)                                                \
+	static void name(const WaterKernelState *state)                                                \
+	{                                                                                              \
+		for (int x = 0; x < WATER_SIZE; x++)                                                       \
+		{                                                                                          \
+			float noiseXOffset = (x + state->xOff) / 10.0f;                                        \
+			for (int y = 0; y < WATER_SIZE; y++)                                                   \
+			{                                                                                      \
+				WaterPoint *point = &state->water[x][y];                                           \
+				point->height = noise2(noiseXOffset, (y + state->yOff) / 10.0f);                   \
+				point->intHeight = point->height * 4096;                                           \
+				point->finalHeight = point->intHeight;                                             \
+				WaterColor(point, &state->sand[x][y], style, floatHeight);                         \
+			}                                                                                      \
+		}                                                                                          \
+	}
+
+// Perlin noise on every updateInterval points, the first point of a row follows the last one of the previous row
+#define WATER_PERLIN_KERNEL(name, style)                                                           \
+	static void name(const WaterKernelState *state)                                                \
+	{                                                                                              \
+		int y = state->updatePhase;                                                                \
+		for (int x = 0; x < WATER_SIZE; x++)                                                       \
+		{                                                                                          \
+			float noiseXOffset = (x + state->xOff) / 10.0f;                                        \
+			for (; y < WATER_SIZE; y += state->updateInterval)                                     \
+			{                                                                                      \
+				WaterPoint *point = &state->water[x][y];                                           \
+				point->height = noise2(noiseXOffset, (y + state->yOff) / 10.0f);                   \
+				point->intHeight = point->height * 4096;                                           \
+				point->finalHeight = point->intHeight;                                             \
+				WaterColor(point, &state->sand[x][y], style, true);                                \
+			}                                                                                      \
+			y -= WATER_SIZE;                                                                       \
+		}                                                                                          \
+	}
+
+// Interpolation from the static noise values on every updateInterval points
+#define WATER_FAST_KERNEL(name, style)                                                             \
+	static void name(const WaterKernelState *state)                                                \
+	{                                                                                              \
+		WaterPoint(*water)[WATER_SIZE] = state->water;                                             \
+		int y = state->updatePhase;                                                                \
+		for (int x = 0; x < WATER_SIZE; x++)                                                       \
+		{                                                                                          \
+			const WaterPoint *row0 = water[(x + state->gridXOff) % WATER_SIZE];                    \
+			const WaterPoint *row1 = water[(x + 1 + state->gridXOff) % WATER_SIZE];                \
+			for (; y < WATER_SIZE; y += state->updateInterval)                                     \
+			{                                                                                      \
+				int h = KernelLerp(row0[y].intHeight, row1[y].intHeight, state->xOff);             \
+				h += KernelLerp(water[x][(y + state->gridYOff) % WATER_SIZE].intHeight,            \
+								water[x][(y + 1 + state->gridYOff) % WATER_SIZE].intHeight,        \
+								state->yOff);                                                      \
+				water[x][y].finalHeight = h / 2;                                                   \
+				WaterColor(&water[x][y], &state->sand[x][y], style, false);                        \
+			}                                                                                      \
+			y -= WATER_SIZE;                                                                       \
+		}                                                                                          \
+	}
+
+// Simplex noise on every point, one row of the grid at a time
+#define WATER_SIMPLEX_KERNEL(name, style)                                                          \
+	static void name(const WaterKernelState *state)                                                \
+	{                                                                                              \
+		int heights[WATER_SIZE];                                                                   \
+		for (int x = 0; x < WATER_SIZE; x++)                                                       \
+		{                                                                                          \
+			/* The points of a row go along y, so y is the first noise coordinate */               \
+			simplex3Row(heights, WATER_SIZE, state->worldY * WATER_SIMPLEX_STEP,                   \
+						(state->worldX + x) * WATER_SIMPLEX_STEP, state->time, WATER_SIMPLEX_STEP); \
+			for (int y = 0; y < WATER_SIZE; y++)                                                   \
+			{                                                                                      \
+				state->water[x][y].finalHeight = heights[y];                                       \
+				WaterColor(&state->water[x][y], &state->sand[x][y], style, false);                 \
+			}                                                                                      \
+		}                                                                                          \
+	}
+
+// Two phase flow map: each point blends two simplex samples moved along its flow for half a cycle apart,
+// a sample restarts from the point when its weight is zero so the pattern never stretches
+#define WATER_FLOW_KERNEL(name, style)                                                             \
+	static void name(const WaterKernelState *state)                                                \
+	{                                                                                              \
+		int phaseA = state->time & 4095;                                                           \
+		int phaseB = (phaseA + 2048) & 4095;                                                       \
+		int weightA = 4096 - (phaseA > 2048 ? 2 * phaseA - 4096 : 4096 - 2 * phaseA);              \
+		int weightB = 4096 - weightA;                                                              \
+		const FlowVector *flow = state->flow;                                                      \
+		for (int x = 0; x < WATER_SIZE; x++)                                                       \
+		{                                                                                          \
+			int noiseX = (state->worldX + x) * WATER_SIMPLEX_STEP;                                 \
+			for (int y = 0; y < WATER_SIZE; y++)                                                   \
+			{                                                                                      \
+				int noiseY = (state->worldY + y) * WATER_SIMPLEX_STEP;                             \
+				int flowX = FLOW_X(flow[x * WATER_SIZE + y]);                                      \
+				int flowY = FLOW_Y(flow[x * WATER_SIZE + y]);                                      \
+				int heightA = simplex2(noiseX - ((flowX * phaseA) >> WATER_FLOW_DISTANCE_SHIFT),   \
+									   noiseY - ((flowY * phaseA) >> WATER_FLOW_DISTANCE_SHIFT));  \
+				int heightB = simplex2(noiseX - ((flowX * phaseB) >> WATER_FLOW_DISTANCE_SHIFT) +  \
+										   WATER_FLOW_PHASE_OFFSET,                                \
+									   noiseY - ((flowY * phaseB) >> WATER_FLOW_DISTANCE_SHIFT));  \
+				state->water[x][y].finalHeight = (heightA * weightA + heightB * weightB) >> 12;    \
+				WaterColor(&state->water[x][y], &state->sand[x][y], style, false);                 \
+			}                                                                                      \
+		}                                                                                          \
+	}
+
+// Color every point, for the modes that set the heights themselves
+#define WATER_COLOR_KERNEL(name, style)                                                            \
+	static void name(const WaterKernelState *state)                                                \
+	{                                                                                              \
+		WaterPoint *points = &state->water[0][0];                                                  \
+		const SandPoint *sand = &state->sand[0][0];                                                \
+		for (int i = 0; i < WATER_POINT_COUNT; i++)                                                \
+			WaterColor(&points[i], &sand[i], style, false);                                        \
+	}
+
+WATER_INIT_KERNEL(WaterInitPerlinOpaque, WATER_STYLE_OPAQUE, true)
+WATER_INIT_KERNEL(WaterInitPerlinClear, WATER_STYLE_CLEAR, true)
+WATER_INIT_KERNEL(WaterInitPerlinSky, WATER_STYLE_SKY, true)
+WATER_INIT_KERNEL(WaterInitOpaque, WATER_STYLE_OPAQUE, false)
+WATER_INIT_KERNEL(WaterInitClear, WATER_STYLE_CLEAR, false)
+WATER_INIT_KERNEL(WaterInitSky, WATER_STYLE_SKY, false)
+WATER_PERLIN_KERNEL(WaterPerlinOpaque, WATER_STYLE_OPAQUE)
+WATER_PERLIN_KERNEL(WaterPerlinClear, WATER_STYLE_CLEAR)
+WATER_PERLIN_KERNEL(WaterPerlinSky, WATER_STYLE_SKY)
+WATER_FAST_KERNEL(WaterFastOpaque, WATER_STYLE_OPAQUE)
+WATER_FAST_KERNEL(WaterFastClear, WATER_STYLE_CLEAR)
+WATER_FAST_KERNEL(WaterFastSky, WATER_STYLE_SKY)
+WATER_SIMPLEX_KERNEL(WaterSimplexOpaque, WATER_STYLE_OPAQUE)
+WATER_SIMPLEX_KERNEL(WaterSimplexClear, WATER_STYLE_CLEAR)
+WATER_SIMPLEX_KERNEL(WaterSimplexSky, WATER_STYLE_SKY)
+WATER_FLOW_KERNEL(WaterFlowOpaque, WATER_STYLE_OPAQUE)
+WATER_FLOW_KERNEL(WaterFlowClear, WATER_STYLE_CLEAR)
+WATER_FLOW_KERNEL(WaterFlowSky, WATER_STYLE_SKY)
+WATER_COLOR_KERNEL(WaterColorOpaque, WATER_STYLE_OPAQUE)
+WATER_COLOR_KERNEL(WaterColorClear, WATER_STYLE_CLEAR)
+WATER_COLOR_KERNEL(WaterColorSky, WATER_STYLE_SKY)
+
+const WaterKernelSet waterKernelTable[WATER_MODE_COUNT][WATER_STYLE_COUNT] = {
+	[WATER_MODE_PERLIN] = {{WaterInitPerlinOpaque, WaterPerlinOpaque}, {WaterInitPerlinClear, WaterPerlinClear}, {WaterInitPerlinSky, WaterPerlinSky}},
+	[WATER_MODE_FAST] = {{WaterInitOpaque, WaterFastOpaque}, {WaterInitClear, WaterFastClear}, {WaterInitSky, WaterFastSky}},
+	[WATER_MODE_GERSTNER] = {{WaterInitOpaque, WaterColorOpaque}, {WaterInitClear, WaterColorClear}, {WaterInitSky, WaterColorSky}},
+	[WATER_MODE_FBM] = {{WaterInitOpaque, WaterColorOpaque}, {WaterInitClear, WaterColorClear}, {WaterInitSky, WaterColorSky}},
+	// The animation has baked colors for the clear style
+	[WATER_MODE_PLAYBACK] = {{WaterInitOpaque, WaterColorOpaque}, {WaterInitClear, NULL}, {WaterInitSky, WaterColorSky}},
+	[WATER_MODE_PIPES] = {{WaterInitOpaque, WaterColorOpaque}, {WaterInitClear, WaterColorClear}, {WaterInitSky, WaterColorSky}},
+	[WATER_MODE_SIMPLEX] = {{WaterInitOpaque, WaterSimplexOpaque}, {WaterInitClear, WaterSimplexClear}, {WaterInitSky, WaterSimplexSky}},
+	[WATER_MODE_FLOW] = {{WaterInitOpaque, WaterFlowOpaque}, {WaterInitClear, WaterFlowClear}, {WaterInitSky, WaterFlowSky}},
+};
+
+/**
+ * @brief Select the kernels of a mode and style, called when one of them changes
+ *
+ * @param mode
+ * @param style
+ */
+void WaterKernelsSelect(WaterMode mode, WaterStyle style)
+{
+	waterKernels = waterKernelTable[mode][style];
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef WATERKERNELS_H_ /* Include guard */
+#define WATERKERNELS_H_
+
+// Shared by the game and the host benchmark, only uses the standard headers
+#include "water.h"
+
+// Inputs of the kernels, set by UpdateWater before every call
+typedef struct
+{
+    WaterPoint (*water)[WATER_SIZE];
+    SandPoint (*sand)[WATER_SIZE];
+    float xOff;         // Noise offset in Perlin mode, interpolation position in fast mode
+    float yOff;
+    int gridXOff;       // Offset of the static noise values in fast mode
+    int gridYOff;
+    int updateInterval; // Perlin and fast modes update one point every updateInterval points
+    int updatePhase;    // First point updated, lower than updateInterval
+    int worldX;         // World cell of the first point, for the simplex mode
+    int worldY;
+    int time;           // Third noise dimension of the simplex mode, 20.12 fixed point, the fraction is the phase of the flow mode
+    const uint16_t *flow; // Packed flow vectors of the flow mode, in the order of the water grid
+} WaterKernelState;
+
+typedef void (*WaterKernel)(const WaterKernelState *state);
+
+typedef struct
+{
+    WaterKernel init; // Sets every point from noise
+    WaterKernel step; // Runs after the simulation of the mode, NULL if there is nothing to do
+} WaterKernelSet;
+
+// Kernels of every mode and style
+extern const WaterKernelSet waterKernelTable[WATER_MODE_COUNT][WATER_STYLE_COUNT];
+// Kernels of the current mode and style
+extern WaterKernelSet waterKernels;
+
+void WaterKernelsSelect(WaterMode mode, WaterStyle style);
+
+#endif // WATERKERNELS_H_
\ No newline at end of file
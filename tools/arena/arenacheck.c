@@ -0,0 +1,125 @@
+// Host check and dump of the memory arena.
+// It makes the startup allocations of the game in the same order and with the same sizes:
+// AllocateWaterGrids, ChunkCacheInit, the fBm octaves of FbmInit, then WaterAnimOpen with the
+// header of the animation file. The structures only use fixed size fields, so they have the
+// same size as on the DS. It checks the alignment, the zeroed memory, the per subsystem counts
+// and that an allocation that does not fit returns NULL and is counted, then prints the dump
+// the game writes to the SD card.
+
+#include "animcodec.h"
+#include "arena.h"
+#include "chunk.h"
+#include "fbm.h"
+#include "flowmap.h"
+#include "particles.h"
+#include "pipes.h"
+#include "scenedraw.h"
+#include "skymap.h"
+#include "water.h"
+#include "wateranim.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define DEFAULT_ANIM_PATH "../../nitrofiles/water.anim"
+
+static int errors = 0;
+
+static void Check(bool ok, const char *format, int a, int b)
+{
+	if (ok)
+		return;
+	printf("FAILED: ");
+	printf(format, a, b);
+	printf("\n");
+	errors++;
+}
+
+/**
+ * @brief Allocate and check that the memory is aligned and zeroed
+ *
+ * @return void*
+ */
+static void *Alloc(ArenaSubsystem subsystem, int size)
+{
+	uint8_t *memory = ArenaAlloc(subsystem, size);
+	Check(memory != NULL, "subsystem %d: %d bytes did not fit", subsystem, size);
+	if (!memory)
+		return NULL;
+
+	Check((uintptr_t)memory % ARENA_ALIGNMENT == 0, "allocation %d not aligned, offset %d", size, (int)((uintptr_t)memory % ARENA_ALIGNMENT));
+	for (int i = 0; i < size; i++)
+	{
+		if (memory[i])
+		{
+			Check(false, "allocation %d not zeroed at %d", size, i);
+			break;
+		}
+		// Dirty it, a later allocation must not see it
+		memory[i] = 0xFF;
+	}
+	return memory;
+}
+
+/**
+ * @brief Allocate the animation buffers like WaterAnimOpen, nothing if the file is missing like the game
+ *
+ */
+static void AllocAnim(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	AnimHeader header;
+	if (!file || fread(&header, sizeof(header), 1, file) != 1 || header.magic != ANIM_MAGIC)
+	{
+		printf("No animation in %s, the playback buffers are not allocated\n", path);
+		if (file)
+			fclose(file);
+		return;
+	}
+	fclose(file);
+
+	Alloc(ARENA_WATER_ANIM, (header.frameCount + 1) * sizeof(uint32_t));
+	for (int i = 0; i < WATER_ANIM_RING_SIZE; i++)
+		Alloc(ARENA_WATER_ANIM, header.maxFrameSize);
+}
+
+int main(int argc, char **argv)
+{
+	// AllocateWaterGrids
+	Alloc(ARENA_WATER_GRIDS, sizeof(WaterPoint) * WATER_SIZE * WATER_SIZE);
+	Alloc(ARENA_WATER_GRIDS, sizeof(SandPoint) * WATER_SIZE * WATER_SIZE);
+	Alloc(ARENA_WATER_GRIDS, sizeof(FlowVector) * WATER_SIZE * WATER_SIZE);
+	Alloc(ARENA_SKY, SKY_TABLE_SIZE * sizeof(uint32_t));
+	Alloc(ARENA_SAND_LIST, SCENE_SAND_LIST_WORDS * sizeof(uint32_t));
+	Alloc(ARENA_PIPES, PipesBufferSize(WATER_SIZE, WATER_SIZE));
+	Alloc(ARENA_PARTICLES, ParticlesBufferSize(SPRAY_PARTICLES));
+	Alloc(ARENA_PARTICLES, ParticlesListSize(SPRAY_PARTICLES));
+	// ChunkCacheInit
+	Alloc(ARENA_CHUNKS, CHUNK_CACHE_SIZE * sizeof(SandChunk));
+	// FbmInit
+	for (int i = 0; i < FBM_MAX_OCTAVES; i++)
+		Alloc(ARENA_FBM, FBM_SNAPSHOTS * FBM_CELL_COUNT * sizeof(int16_t));
+	AllocAnim(argc > 1 ? argv[1] : DEFAULT_ANIM_PATH);
+
+	int used = 0;
+	for (int i = 0; i < ARENA_SUBSYSTEM_COUNT; i++)
+		used += arenaStats[i].used;
+	Check(used == arenaUsed, "subsystems use %d bytes, arena %d", used, arenaUsed);
+	Check(arenaFailedAllocations == 0, "%d failed allocations, expected %d", arenaFailedAllocations, 0);
+	ArenaDump(stdout);
+
+	// An allocation that does not fit leaves the arena untouched
+	int before = arenaUsed;
+	Check(ArenaAlloc(ARENA_FBM, ARENA_SIZE) == NULL, "a whole arena fit after %d bytes, %d failures", before, arenaFailedAllocations);
+	Check(ArenaAlloc(ARENA_FBM, -1) == NULL, "a negative size fit after %d bytes, %d failures", before, arenaFailedAllocations);
+	Check(arenaFailedAllocations == 2, "%d failed allocations, expected %d", arenaFailedAllocations, 2);
+	Check(arenaUsed == before, "failed allocations used %d bytes, %d before", arenaUsed, before);
+
+	if (errors)
+	{
+		printf("%d errors\n", errors);
+		return 1;
+	}
+	printf("Allocations aligned and zeroed, counts ok\n");
+	return 0;
+}
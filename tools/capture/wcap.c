@@ -0,0 +1,133 @@
+// Host tool reading water captures recorded with the Y button.
+// With one file it prints a summary, with two files it compares them frame by frame
+// to check that an optimisation of the simulation did not change its output.
+
+#include "capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static int Summary(const char *path)
+{
+	CaptureReader reader;
+	if (CaptureReaderOpen(&reader, path) != 0)
+	{
+		fprintf(stderr, "%s: not a valid capture\n", path);
+		return 1;
+	}
+
+	int cellCount = reader.header.width * reader.header.height;
+	CaptureFrame frame;
+	if (CaptureFrameAlloc(&frame, cellCount) != 0)
+		return 1;
+
+	double timerSums[CAPTURE_MAX_TIMERS] = {0};
+	uint32_t timerMax[CAPTURE_MAX_TIMERS] = {0};
+	for (uint32_t f = 0; f < reader.frameCount; f++)
+	{
+		if (CaptureReaderGetFrame(&reader, f, &frame) != 0)
+		{
+			fprintf(stderr, "%s: frame %u failed to decode\n", path, f);
+			return 1;
+		}
+		for (int t = 0; t < reader.header.timerCount; t++)
+		{
+			timerSums[t] += frame.timers[t];
+			if (frame.timers[t] > timerMax[t])
+				timerMax[t] = frame.timers[t];
+		}
+	}
+
+	printf("%s: %ux%u grid, %u frames in %u chunks\n", path, reader.header.width, reader.header.height, reader.frameCount, reader.chunkCount);
+	printf("File size: %u bytes, %.1f bytes per frame, raw %d bytes per frame\n", reader.size,
+		   reader.frameCount ? (double)reader.size / reader.frameCount : 0.0,
+		   cellCount * 10 + reader.header.timerCount * 4);
+	for (int t = 0; t < reader.header.timerCount; t++)
+	{
+		printf("Timer %d: average %.0f ticks, max %u ticks\n", t,
+			   reader.frameCount ? timerSums[t] / reader.frameCount : 0.0, timerMax[t]);
+	}
+
+	CaptureFrameFree(&frame);
+	CaptureReaderClose(&reader);
+	return 0;
+}
+
+static int Compare(const char *pathA, const char *pathB)
+{
+	CaptureReader readerA, readerB;
+	if (CaptureReaderOpen(&readerA, pathA) != 0 || CaptureReaderOpen(&readerB, pathB) != 0)
+	{
+		fprintf(stderr, "Invalid capture\n");
+		return 1;
+	}
+	if (readerA.header.width != readerB.header.width || readerA.header.height != readerB.header.height)
+	{
+		fprintf(stderr, "The grid sizes are different\n");
+		return 1;
+	}
+
+	int cellCount = readerA.header.width * readerA.header.height;
+	CaptureFrame frameA, frameB;
+	if (CaptureFrameAlloc(&frameA, cellCount) != 0 || CaptureFrameAlloc(&frameB, cellCount) != 0)
+		return 1;
+
+	uint32_t frameCount = readerA.frameCount < readerB.frameCount ? readerA.frameCount : readerB.frameCount;
+	uint32_t differentFrames = 0;
+	int64_t firstDifferent = -1;
+	int maxHeightDiff = 0;
+	int maxSandDiff = 0;
+	long colorDiffs = 0;
+	for (uint32_t f = 0; f < frameCount; f++)
+	{
+		if (CaptureReaderGetFrame(&readerA, f, &frameA) != 0 || CaptureReaderGetFrame(&readerB, f, &frameB) != 0)
+		{
+			fprintf(stderr, "Frame %u failed to decode\n", f);
+			return 1;
+		}
+
+		int different = 0;
+		for (int i = 0; i < cellCount; i++)
+		{
+			int heightDiff = abs(frameA.heights[i] - frameB.heights[i]);
+			int sandDiff = abs(frameA.sand[i] - frameB.sand[i]);
+			if (heightDiff > maxHeightDiff)
+				maxHeightDiff = heightDiff;
+			if (sandDiff > maxSandDiff)
+				maxSandDiff = sandDiff;
+			if (frameA.colors[i] != frameB.colors[i])
+				colorDiffs++;
+			different |= heightDiff || sandDiff || frameA.colors[i] != frameB.colors[i];
+		}
+		if (different)
+		{
+			differentFrames++;
+			if (firstDifferent < 0)
+				firstDifferent = f;
+		}
+	}
+
+	printf("Compared %u frames: %u different", frameCount, differentFrames);
+	if (firstDifferent >= 0)
+		printf(" (first: %lld)", (long long)firstDifferent);
+	printf("\nMax height difference: %d (%.4f), max sand difference: %d, different colors: %ld\n",
+		   maxHeightDiff, maxHeightDiff / 4096.0, maxSandDiff, colorDiffs);
+	if (readerA.frameCount != readerB.frameCount)
+		printf("Frame counts differ: %u and %u\n", readerA.frameCount, readerB.frameCount);
+
+	CaptureFrameFree(&frameA);
+	CaptureFrameFree(&frameB);
+	CaptureReaderClose(&readerA);
+	CaptureReaderClose(&readerB);
+	return differentFrames != 0 || readerA.frameCount != readerB.frameCount;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 2)
+		return Summary(argv[1]);
+	if (argc == 3)
+		return Compare(argv[1], argv[2]);
+
+	fprintf(stderr, "Usage: %s capture.wcap [other.wcap]\n", argv[0]);
+	return 1;
+}
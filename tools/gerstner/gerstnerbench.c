@@ -0,0 +1,134 @@
+// Host benchmark of the Gerstner water mode.
+// It times a simulation step of the Gerstner mode, the sum of the waves and the color kernel,
+// against the steps of the Perlin and fast modes with the update interval of the game,
+// and checks that the Gerstner heights stay in the 0 to 1 range of noise2 used by the colors.
+
+#include "gerstner.h"
+#include "waterkernels.h"
+#include "noise.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_RUNS 20000
+// Default update interval of the Perlin and fast modes in the game
+#define UPDATE_INTERVAL 2
+
+static WaterPoint water[WATER_SIZE][WATER_SIZE];
+static SandPoint sand[WATER_SIZE][WATER_SIZE];
+
+static double Seconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Set the sand like the chunks of the game and the water from the init kernel of a mode
+ *
+ */
+static void InitGrids(WaterKernelState *state, WaterMode mode)
+{
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			sand[x][y].height = noise2((x + 10) / 4.0, (y + 5) / 4.0) * 2 - 1;
+			sand[x][y].intHeight = sand[x][y].height * 4096;
+		}
+	}
+	waterKernelTable[mode][WATER_STYLE_CLEAR].init(state);
+}
+
+/**
+ * @brief Time the step of a noise mode, like UpdateWater runs it
+ *
+ * @return double Nanoseconds per grid point
+ */
+static double BenchNoiseMode(WaterMode mode, int runs)
+{
+	WaterKernelState state = {
+		.water = water,
+		.sand = sand,
+		.xOff = 123,
+		.yOff = 456,
+		.updateInterval = UPDATE_INTERVAL,
+	};
+	InitGrids(&state, mode);
+	WaterKernel step = waterKernelTable[mode][WATER_STYLE_CLEAR].step;
+
+	double start = Seconds();
+	for (int i = 0; i < runs; i++)
+	{
+		state.updatePhase = (state.updatePhase + 1) % UPDATE_INTERVAL;
+		if (mode == WATER_MODE_FAST)
+			state.xOff = (i % 20) / 20.0f;
+		else
+			state.xOff += 0.05f;
+		step(&state);
+	}
+	return (Seconds() - start) * 1e9 / ((double)runs * WATER_SIZE * WATER_SIZE);
+}
+
+/**
+ * @brief Time the step of the Gerstner mode and get its height range
+ *
+ * @return double Nanoseconds per grid point
+ */
+static double BenchGerstner(int runs, int *minHeight, int *maxHeight)
+{
+	WaterKernelState state = {
+		.water = water,
+		.sand = sand,
+	};
+	InitGrids(&state, WATER_MODE_PERLIN);
+	GerstnerInit();
+	WaterKernel step = waterKernelTable[WATER_MODE_GERSTNER][WATER_STYLE_CLEAR].step;
+
+	*minHeight = 4096;
+	*maxHeight = 0;
+	double start = Seconds();
+	for (int i = 0; i < runs; i++)
+	{
+		GerstnerUpdate(water, 1);
+		step(&state);
+	}
+	double time = Seconds() - start;
+
+	// Range over the whole wave cycle, out of the timed loop
+	for (int i = 0; i < 4096; i++)
+	{
+		GerstnerUpdate(water, 1);
+		for (int x = 0; x < WATER_SIZE; x++)
+		{
+			for (int y = 0; y < WATER_SIZE; y++)
+			{
+				if (water[x][y].finalHeight < *minHeight)
+					*minHeight = water[x][y].finalHeight;
+				if (water[x][y].finalHeight > *maxHeight)
+					*maxHeight = water[x][y].finalHeight;
+			}
+		}
+	}
+	return time * 1e9 / ((double)runs * WATER_SIZE * WATER_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+	int runs = argc > 1 ? atoi(argv[1]) : DEFAULT_RUNS;
+
+	double perlinTime = BenchNoiseMode(WATER_MODE_PERLIN, runs);
+	double fastTime = BenchNoiseMode(WATER_MODE_FAST, runs);
+	int minHeight;
+	int maxHeight;
+	double gerstnerTime = BenchGerstner(runs, &minHeight, &maxHeight);
+
+	printf("Perlin    step %7.2f ns/point (one point in %d updated)\n", perlinTime, UPDATE_INTERVAL);
+	printf("Fast      step %7.2f ns/point (one point in %d updated)\n", fastTime, UPDATE_INTERVAL);
+	printf("Gerstner  step %7.2f ns/point (%d waves and the colors)\n", gerstnerTime, gerstnerWaveCount);
+
+	bool inRange = minHeight >= 0 && maxHeight <= 4096;
+	printf("Gerstner heights %d to %d  %s\n", minHeight, maxHeight, inRange ? "ok" : "OUT OF THE NOISE2 RANGE");
+	return !inRange;
+}
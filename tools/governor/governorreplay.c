@@ -0,0 +1,156 @@
+// Host replay of frame costs through the quality governor.
+// It replays built-in traces of load spikes and checks the level changes: short spikes and
+// costs inside the hysteresis band keep the level, sustained load lowers it one level at a
+// time down to the cheapest, and a long light period raises it again. A trace file with one
+// "ticks polygons" frame per line can also be replayed, its level changes are printed.
+
+#include "governor.h"
+#include <stdio.h>
+#include <string.h>
+
+// Frame costs of the built-in traces
+#define HEAVY_TICKS (GOVERNOR_FRAME_TICKS * 95 / 100)
+#define BAND_TICKS (GOVERNOR_FRAME_TICKS * 70 / 100)
+#define LIGHT_TICKS (GOVERNOR_FRAME_TICKS * 40 / 100)
+#define POLYGONS 700
+#define DEFAULT_LEVEL 1
+
+// Settings applied by the governor, to check that every change reaches the game
+static GovernorLevel appliedSettings;
+static int applyCount = 0;
+
+static void Apply(const GovernorLevel *settings)
+{
+	appliedSettings = *settings;
+	applyCount++;
+}
+
+/**
+ * @brief Feed the same frame cost to the governor several times
+ *
+ * @return int Number of level changes
+ */
+static int Replay(uint32_t ticks, int polygons, int frames)
+{
+	int changes = 0;
+	for (int i = 0; i < frames; i++)
+		changes += GovernorUpdate(ticks, polygons);
+	return changes;
+}
+
+/**
+ * @brief Print the result of a check
+ *
+ * @return int 0 if the level is the expected one
+ */
+static int Expect(const char *name, int expectedLevel)
+{
+	bool applied = memcmp(&appliedSettings, &governorLevels[governorLevel], sizeof(GovernorLevel)) == 0;
+	bool ok = governorLevel == expectedLevel && applied;
+	printf("%-44s level %d (expected %d)%s  %s\n", name, governorLevel, expectedLevel,
+		   applied ? "" : ", settings not applied", ok ? "ok" : "FAILED");
+	return !ok;
+}
+
+static int RunChecks()
+{
+	int errors = 0;
+
+	GovernorInit(Apply);
+	errors += Expect("Init", DEFAULT_LEVEL);
+
+	// Short spikes under GOVERNOR_DOWN_FRAMES, separated by normal frames
+	for (int i = 0; i < 50; i++)
+	{
+		Replay(HEAVY_TICKS, POLYGONS, GOVERNOR_DOWN_FRAMES - 1);
+		Replay(BAND_TICKS, POLYGONS, 1);
+	}
+	errors += Expect("Spikes shorter than the down frames", DEFAULT_LEVEL);
+
+	// Alternating heavy and light frames never stay on one side long enough
+	for (int i = 0; i < GOVERNOR_UP_FRAMES * 2; i++)
+		Replay(i % 2 ? HEAVY_TICKS : LIGHT_TICKS, POLYGONS, 1);
+	errors += Expect("Alternating heavy and light frames", DEFAULT_LEVEL);
+
+	// Costs inside the hysteresis band keep the level
+	Replay(BAND_TICKS, POLYGONS, GOVERNOR_UP_FRAMES * 4);
+	errors += Expect("Frames inside the hysteresis band", DEFAULT_LEVEL);
+
+	// A sustained spike lowers the level once per GOVERNOR_DOWN_FRAMES
+	Replay(HEAVY_TICKS, POLYGONS, GOVERNOR_DOWN_FRAMES);
+	errors += Expect("Sustained spike", DEFAULT_LEVEL + 1);
+	Replay(HEAVY_TICKS, POLYGONS, GOVERNOR_DOWN_FRAMES - 1);
+	errors += Expect("Heavy frames counted again after a change", DEFAULT_LEVEL + 1);
+
+	// Light frames just short of GOVERNOR_UP_FRAMES, then a band frame resets the count
+	Replay(LIGHT_TICKS, POLYGONS, GOVERNOR_UP_FRAMES - 1);
+	Replay(BAND_TICKS, POLYGONS, 1);
+	Replay(LIGHT_TICKS, POLYGONS, GOVERNOR_UP_FRAMES - 1);
+	errors += Expect("Light frames interrupted by a band frame", DEFAULT_LEVEL + 1);
+	Replay(LIGHT_TICKS, POLYGONS, 1);
+	errors += Expect("Light period", DEFAULT_LEVEL);
+
+	// Too many polygons is a heavy frame even when the time is light
+	Replay(LIGHT_TICKS, GOVERNOR_POLYGON_LIMIT + 1, GOVERNOR_DOWN_FRAMES);
+	errors += Expect("Polygon overload", DEFAULT_LEVEL + 1);
+
+	// A long overload goes down to the cheapest level and stays there
+	Replay(HEAVY_TICKS, POLYGONS, GOVERNOR_DOWN_FRAMES * (governorLevelCount + 2));
+	errors += Expect("Long overload", governorLevelCount - 1);
+
+	// And a long light period goes back to the best level
+	Replay(LIGHT_TICKS, POLYGONS, GOVERNOR_UP_FRAMES * (governorLevelCount + 2));
+	errors += Expect("Long light period", 0);
+
+	// Disabled, nothing changes
+	governorEnabled = false;
+	int changes = Replay(HEAVY_TICKS, POLYGONS, GOVERNOR_DOWN_FRAMES * 4);
+	governorEnabled = true;
+	errors += Expect("Disabled governor", 0);
+	if (changes != 0)
+		errors++;
+
+	// Spike, light period and polygon overload, then down from level 2 and up from the cheapest
+	int expectedLogs = 3 + (governorLevelCount - 1 - (DEFAULT_LEVEL + 1)) + (governorLevelCount - 1);
+	bool logOk = governorLogCount == expectedLogs && applyCount == expectedLogs + 1;
+	printf("%-44s %d changes logged, %d applied (expected %d)  %s\n", "Change log",
+		   governorLogCount, applyCount, expectedLogs, logOk ? "ok" : "FAILED");
+	return errors + !logOk;
+}
+
+/**
+ * @brief Replay a trace file and print every level change
+ *
+ * @return int 0 on success
+ */
+static int ReplayFile(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (!file)
+	{
+		fprintf(stderr, "Can't open %s\n", path);
+		return 1;
+	}
+
+	GovernorInit(Apply);
+	unsigned int ticks;
+	int polygons;
+	int frames = 0;
+	while (fscanf(file, "%u %d", &ticks, &polygons) == 2)
+	{
+		frames++;
+		if (GovernorUpdate(ticks, polygons))
+			printf("frame %6d  %6u ticks (%3u%% of a frame)  %4d polygons  level %d\n",
+				   frames, ticks, (unsigned int)((unsigned long long)ticks * 100 / GOVERNOR_FRAME_TICKS), polygons, governorLevel);
+	}
+	fclose(file);
+	printf("%d frames, %d level changes, final level %d\n", frames, governorLogCount, governorLevel);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1)
+		return ReplayFile(argv[1]);
+	return RunChecks() != 0;
+}
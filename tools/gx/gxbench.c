@@ -0,0 +1,288 @@
+// Host recorder of the scene draw paths.
+// It draws the sand, caustics, water, spray and cube through the recording geometry engine
+// for every mesh step, prints the command counters and the vertex and polygon RAM budget,
+// and times the draw paths. The water styles are compared on the full mesh, the sky style
+// including the update of its texture coordinates. The map of the bottom screen in dual screen mode
+// is recorded on its own, with the sand display list shared with the top screen. The command stream of the full mesh can be saved, or compared
+// with a saved one to check that a draw path change sends the same commands.
+
+#include "scenedraw.h"
+#include "waterkernels.h"
+#include "particles.h"
+#include "skymap.h"
+#include "noise.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_RUNS 5000
+#define MAX_MESH_STEP 4
+
+static WaterPoint water[WATER_SIZE][WATER_SIZE];
+static SandPoint sand[WATER_SIZE][WATER_SIZE];
+static int meshIndices[WATER_SIZE];
+static GxMaterial sandMaterial = {1};
+static GxMaterial causticsMaterial = {2};
+static GxMaterial cubeMaterial = {3};
+static GxMaterial skyMaterial = {4};
+static uint32_t skyTable[SKY_TABLE_SIZE];
+static uint32_t sandList[SCENE_SAND_LIST_WORDS];
+
+static const char *styleNames[WATER_STYLE_COUNT] = {
+	[WATER_STYLE_OPAQUE] = "opaque",
+	[WATER_STYLE_CLEAR] = "clear",
+	[WATER_STYLE_SKY] = "sky",
+};
+
+static double Seconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Set the grids like the game does with the simplex water mode
+ *
+ */
+static void InitGrids()
+{
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			sand[x][y].height = noise2((x + 10) / 4.0, (y + 5) / 4.0) * 2 - 1;
+			sand[x][y].intHeight = sand[x][y].height * 4096;
+			sand[x][y].causticsColor = RGB15(31, 31, 31);
+		}
+	}
+
+	WaterKernelState state = {
+		.water = water,
+		.sand = sand,
+		.worldX = 12,
+		.worldY = 34,
+		.time = 5000,
+	};
+	waterKernelTable[WATER_MODE_SIMPLEX][WATER_STYLE_CLEAR].init(&state);
+	waterKernelTable[WATER_MODE_SIMPLEX][WATER_STYLE_CLEAR].step(&state);
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		for (int y = 0; y < WATER_SIZE; y++)
+			water[x][y].renderHeight = water[x][y].finalHeight;
+	}
+}
+
+/**
+ * @brief Set the mesh indices like SetWaterDetail
+ *
+ * @param meshStep
+ * @return int Number of indices
+ */
+static int SetMeshStep(int meshStep)
+{
+	int count = 0;
+	for (int i = 0; i < WATER_SIZE - 1; i += meshStep)
+		meshIndices[count++] = i;
+	meshIndices[count++] = WATER_SIZE - 1;
+	return count;
+}
+
+static void DrawScene(const SceneDrawState *scene)
+{
+	DrawSand(scene);
+	DrawCaustics(scene);
+	DrawWater(scene);
+	DrawSpray(scene);
+	DrawCube(scene);
+}
+
+// Same draws as DrawMapScene
+static void DrawMap(const SceneDrawState *scene)
+{
+	DrawSand(scene);
+	DrawCaustics(scene);
+	DrawWater(scene);
+	DrawCube(scene);
+}
+
+/**
+ * @brief Compare the recording with a saved stream
+ *
+ * @param path
+ * @return int 0 if they are the same
+ */
+static int CompareStream(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+	{
+		fprintf(stderr, "Can't open %s\n", path);
+		return 1;
+	}
+	uint32_t word;
+	int index = 0;
+	int difference = -1;
+	while (fread(&word, sizeof(word), 1, file) == 1)
+	{
+		if (index >= gxRecording.size || gxRecording.words[index] != word)
+		{
+			difference = index;
+			break;
+		}
+		index++;
+	}
+	fclose(file);
+	if (difference < 0 && index != gxRecording.size)
+		difference = index;
+
+	if (difference >= 0)
+		printf("Stream differs from %s at word %d of %d\n", path, difference, gxRecording.size);
+	else
+		printf("Stream is the same as %s (%d words)\n", path, gxRecording.size);
+	return difference >= 0;
+}
+
+int main(int argc, char **argv)
+{
+	int runs = DEFAULT_RUNS;
+	const char *outputPath = NULL;
+	const char *referencePath = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			outputPath = argv[++i];
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+			referencePath = argv[++i];
+		else
+			runs = atoi(argv[i]);
+	}
+
+	InitGrids();
+
+	// Spray thrown over the middle of the grid
+	ParticlePool spray;
+	void *sprayBuffer = malloc(ParticlesBufferSize(SPRAY_PARTICLES));
+	uint32_t *sprayList = malloc(ParticlesListSize(SPRAY_PARTICLES));
+	if (!sprayBuffer || !sprayList)
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	ParticlesInit(&spray, SPRAY_PARTICLES, sprayBuffer);
+	ParticlesSpawn(&spray, inttof32(WATER_SIZE), inttof32(4), inttof32(WATER_SIZE), 160, SPRAY_PARTICLES);
+	ParticlesUpdate(&spray, 4);
+	ParticlesBuildList(&spray, sprayList, 4096, 0);
+
+	SceneDrawState scene = {
+		.water = water,
+		.sand = sand,
+		.meshIndices = meshIndices,
+		.worldX = 12,
+		.worldY = 34,
+		.causticsU = 100,
+		.causticsV = 200,
+		.style = WATER_STYLE_CLEAR,
+		.cubeX = inttof32(10),
+		.cubeY = inttof32(2),
+		.cubeZ = inttof32(16),
+		.sprayList = sprayList,
+		.sandList = sandList,
+		.sandMaterial = &sandMaterial,
+		.causticsMaterial = &causticsMaterial,
+		.cubeMaterial = &cubeMaterial,
+		.skyMaterial = &skyMaterial,
+	};
+
+	int errors = 0;
+	for (int meshStep = MAX_MESH_STEP; meshStep >= 1; meshStep--)
+	{
+		scene.meshIndexCount = SetMeshStep(meshStep);
+
+		// Built when the sand or the mesh changes, not every frame
+		double start = Seconds();
+		int listWords = 0;
+		for (int i = 0; i < runs; i++)
+			listWords = SceneBuildSandList(&scene, sandList);
+		double listTime = (Seconds() - start) / runs;
+
+		start = Seconds();
+		for (int i = 0; i < runs; i++)
+		{
+			GxRecordStart();
+			DrawScene(&scene);
+		}
+		double drawTime = (Seconds() - start) / runs;
+
+		GxBudget budget;
+		bool inBudget = GxBudgetCheck(&budget);
+		printf("mesh step %d  %5d commands %6d words  %4d/%d vertices  %4d/%d polygons  %4d pushes (depth %d)  %6.2f us/frame  sand list %4d words %6.2f us  %s\n",
+			   meshStep, gxCounters.commands, gxRecording.size,
+			   budget.vertices, GX_VERTEX_RAM_LIMIT, budget.polygons, GX_POLYGON_RAM_LIMIT,
+			   gxCounters.matrixPushes, gxCounters.maxMatrixDepth, drawTime * 1e6, listWords, listTime * 1e6,
+			   gxCounters.errors ? "ERRORS" : inBudget ? "ok" : "OVER BUDGET");
+		if (gxCounters.errors || !inBudget || gxCounters.matrixDepth != 0)
+			errors++;
+	}
+
+	// Cost of the styles on the full mesh, against the color only ones
+	SkyMapBuildTable(skyTable);
+	for (int style = 0; style < WATER_STYLE_COUNT; style++)
+	{
+		scene.style = style;
+		double start = Seconds();
+		for (int i = 0; i < runs; i++)
+		{
+			if (style == WATER_STYLE_SKY)
+				SkyMapUpdate(water, skyTable, 0);
+			GxRecordStart();
+			DrawWater(&scene);
+		}
+		double drawTime = (Seconds() - start) / runs;
+		printf("water style %-6s  %5d commands %6d words  %6.2f us/frame  %s\n",
+			   styleNames[style], gxCounters.commands, gxRecording.size, drawTime * 1e6, gxCounters.errors ? "ERRORS" : "ok");
+		if (gxCounters.errors)
+			errors++;
+	}
+
+	// Bottom screen of the dual screen mode, on the frames between two top screen frames
+	scene.style = WATER_STYLE_CLEAR;
+	double start = Seconds();
+	for (int i = 0; i < runs; i++)
+	{
+		GxRecordStart();
+		DrawMap(&scene);
+	}
+	double mapTime = (Seconds() - start) / runs;
+	GxBudget mapBudget;
+	bool mapInBudget = GxBudgetCheck(&mapBudget);
+	printf("dual screen map  %5d commands %6d words  %4d/%d vertices  %4d/%d polygons  %6.2f us/frame  %s\n",
+		   gxCounters.commands, gxRecording.size, mapBudget.vertices, GX_VERTEX_RAM_LIMIT,
+		   mapBudget.polygons, GX_POLYGON_RAM_LIMIT, mapTime * 1e6,
+		   gxCounters.errors ? "ERRORS" : mapInBudget ? "ok" : "OVER BUDGET");
+	if (gxCounters.errors || !mapInBudget)
+		errors++;
+
+	// The recording of the full frame is kept for the stream files
+	GxRecordStart();
+	DrawScene(&scene);
+	if (outputPath)
+	{
+		FILE *file = fopen(outputPath, "wb");
+		if (!file || fwrite(gxRecording.words, sizeof(uint32_t), gxRecording.size, file) != (size_t)gxRecording.size)
+		{
+			fprintf(stderr, "Can't write %s\n", outputPath);
+			errors++;
+		}
+		if (file)
+			fclose(file);
+	}
+	if (referencePath)
+		errors += CompareStream(referencePath);
+
+	GxRecordFree();
+	free(sprayBuffer);
+	free(sprayList);
+	return errors != 0;
+}
@@ -0,0 +1,347 @@
+// Host benchmark of the water kernels.
+// For every mode and style it runs the specialised kernels and a copy of the update loop
+// they replaced, which tests the mode and the style on every point, checks that both give
+// the same grid, and reports the time per grid point. The sky style, added after the loop,
+// is timed against the opaque kernel of the same mode and checked to give the same heights
+// and light colors in range. The modes added with the kernels are only timed.
+
+#include "waterkernels.h"
+#include "noise.h"
+#include "flowmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_RUNS 20000
+#define UPDATE_INTERVAL 2
+#define RGB15(r, g, b) ((r) | ((g) << 5) | ((b) << 10))
+
+static const char *modeNames[WATER_MODE_COUNT] = {
+	[WATER_MODE_PERLIN] = "Perlin",
+	[WATER_MODE_FAST] = "Fast",
+	[WATER_MODE_GERSTNER] = "Gerstner",
+	[WATER_MODE_FBM] = "fBm",
+	[WATER_MODE_PLAYBACK] = "Playback",
+	[WATER_MODE_PIPES] = "Pipes",
+	[WATER_MODE_SIMPLEX] = "Simplex",
+	[WATER_MODE_FLOW] = "Flow",
+};
+
+static WaterPoint water[WATER_SIZE][WATER_SIZE];
+static WaterPoint referenceWater[WATER_SIZE][WATER_SIZE];
+static SandPoint sand[WATER_SIZE][WATER_SIZE];
+static FlowVector flow[WATER_SIZE * WATER_SIZE];
+
+static double Seconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+//---------------------------------------------------------------------
+// Update loop before the kernels
+
+static int Lerp(int a, int b, float f)
+{
+	return a * (1 - f) + (b * f);
+}
+
+static void SetWaterColor(WaterPoint (*grid)[WATER_SIZE], int x, int y, WaterMode waterMode, bool clearWater)
+{
+	WaterPoint *point = &grid[x][y];
+	int heightDiff = 0;
+	if (waterMode == WATER_MODE_PERLIN)
+		heightDiff = (point->height * 2 - (sand[x][y].height)) * 200;
+	else
+		heightDiff = (point->finalHeight * 2 - (sand[x][y].intHeight)) * 200 / 4096;
+
+	int colorIntensity = 0;
+	if (waterMode == WATER_MODE_PERLIN)
+		colorIntensity = point->height * 11;
+	else
+		colorIntensity = point->finalHeight / 4096.0f * 11;
+	if (colorIntensity < 0)
+		colorIntensity = 0;
+
+	if (heightDiff <= 20)
+	{
+		if (heightDiff < 0)
+			heightDiff = 0;
+
+		float heightDifRatio = heightDiff / 20.0f;
+		if (clearWater)
+		{
+			int col1 = Lerp(20, colorIntensity, heightDifRatio);
+			int col2 = Lerp(20, 7 + colorIntensity, heightDifRatio);
+			point->color = RGB15(col1, col1, col2);
+		}
+		else
+		{
+			int col1 = Lerp(20, 5 - colorIntensity / 2, heightDifRatio);
+			int col2 = Lerp(20, 11 - colorIntensity, heightDifRatio);
+			int col3 = Lerp(31, 31 - colorIntensity, heightDifRatio);
+			point->color = RGB15(col1, col2, col3);
+		}
+	}
+	else
+	{
+		if (clearWater)
+			point->color = RGB15(colorIntensity, colorIntensity, 7 + colorIntensity);
+		else
+			point->color = RGB15(5 - colorIntensity / 2, 11 - colorIntensity, 31 - colorIntensity);
+	}
+}
+
+static void ReferenceUpdate(const WaterKernelState *state, WaterMode waterMode, bool clearWater, bool initFastWater)
+{
+	WaterPoint(*grid)[WATER_SIZE] = state->water;
+	if ((waterMode == WATER_MODE_GERSTNER || waterMode == WATER_MODE_FBM || waterMode == WATER_MODE_PLAYBACK || waterMode == WATER_MODE_PIPES) && !initFastWater)
+	{
+		if (waterMode == WATER_MODE_PLAYBACK && clearWater)
+			return;
+
+		for (int x = 0; x < WATER_SIZE; x++)
+		{
+			for (int y = 0; y < WATER_SIZE; y++)
+				SetWaterColor(grid, x, y, waterMode, clearWater);
+		}
+		return;
+	}
+
+	bool fastWater = waterMode == WATER_MODE_FAST;
+	int countdown = state->updatePhase;
+	float noiseXOffset = 0;
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		if (!fastWater || initFastWater)
+			noiseXOffset = (x + state->xOff) / 10.0f;
+
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			WaterPoint *point = &grid[x][y];
+			bool needUpdateWater = countdown == 0;
+			if (needUpdateWater)
+				countdown = state->updateInterval;
+			countdown--;
+			if (needUpdateWater || initFastWater)
+			{
+				if (!fastWater || initFastWater)
+				{
+					point->height = noise2(noiseXOffset, (y + state->yOff) / 10.0f);
+					point->intHeight = point->height * 4096;
+					point->finalHeight = point->intHeight;
+				}
+				else
+				{
+					int h = Lerp(grid[(x + state->gridXOff) % WATER_SIZE][y].intHeight, grid[(x + 1 + state->gridXOff) % WATER_SIZE][y].intHeight, state->xOff);
+					h += Lerp(grid[x][(y + state->gridYOff) % WATER_SIZE].intHeight, grid[(x)][(y + 1 + state->gridYOff) % WATER_SIZE].intHeight, state->yOff);
+					h /= 2;
+					point->finalHeight = h;
+				}
+				SetWaterColor(grid, x, y, waterMode, clearWater);
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------
+// Benchmark
+
+/**
+ * @brief Set the sand like the chunks of the game and the water heights like the other modes
+ *
+ */
+static void InitGrids()
+{
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			sand[x][y].height = noise2((x + 10) / 4.0, (y + 5) / 4.0) * 2 - 1;
+			sand[x][y].intHeight = sand[x][y].height * 4096;
+			water[x][y].height = noise2((x + 123) / 10.0f, (y + 456) / 10.0f);
+			water[x][y].intHeight = water[x][y].height * 4096;
+			water[x][y].finalHeight = noise2((x + 7) / 3.0f, (y + 9) / 3.0f) * 4096;
+		}
+	}
+	memcpy(referenceWater, water, sizeof(water));
+	FlowMapBake(flow, sand);
+}
+
+/**
+ * @brief Time a kernel and the reference loop, and compare their grids
+ *
+ * @return int 0 if the grids are the same
+ */
+static int Bench(WaterMode mode, bool clear, bool init, int runs)
+{
+	WaterKernelState state = {
+		.water = water,
+		.sand = sand,
+		.xOff = 0.35f,
+		.yOff = 0.6f,
+		.gridXOff = 3,
+		.gridYOff = 5,
+		.updateInterval = UPDATE_INTERVAL,
+		.updatePhase = 1,
+	};
+	WaterKernelState referenceState = state;
+	referenceState.water = referenceWater;
+	WaterKernelSet kernels = waterKernelTable[mode][clear];
+	WaterKernel kernel = init ? kernels.init : kernels.step;
+
+	InitGrids();
+	double start = Seconds();
+	for (int i = 0; i < runs; i++)
+	{
+		if (kernel)
+			kernel(&state);
+	}
+	double kernelTime = Seconds() - start;
+
+	start = Seconds();
+	for (int i = 0; i < runs; i++)
+		ReferenceUpdate(&referenceState, mode, clear, init);
+	double referenceTime = Seconds() - start;
+
+	bool same = memcmp(water, referenceWater, sizeof(water)) == 0;
+	if (!kernel)
+	{
+		printf("%-8s %-6s %-4s  no kernel, the colors come from the mode  %s\n",
+			   modeNames[mode], clear ? "clear" : "opaque", init ? "init" : "step", same ? "same grid" : "DIFFERENT GRID");
+		return !same;
+	}
+
+	double pointRuns = (double)runs * WATER_SIZE * WATER_SIZE;
+	printf("%-8s %-6s %-4s  kernel %7.2f ns/point  branching %7.2f ns/point  saved %5.1f%%  %s\n",
+		   modeNames[mode], clear ? "clear" : "opaque", init ? "init" : "step",
+		   kernelTime * 1e9 / pointRuns, referenceTime * 1e9 / pointRuns,
+		   referenceTime > 0 ? 100 * (1 - kernelTime / referenceTime) : 0,
+		   same ? "same grid" : "DIFFERENT GRID");
+	return !same;
+}
+
+/**
+ * @brief Time the sky kernel of a mode against its opaque kernel, and check the sky grid
+ *
+ * The heights must be the ones of the opaque kernel, and the colors must be in the light range of the style
+ * without any channel overflowing into the next one
+ *
+ * @return int 0 if the sky grid is valid
+ */
+static int BenchSky(WaterMode mode, bool init, int runs)
+{
+	WaterKernelState state = {
+		.water = water,
+		.sand = sand,
+		.xOff = 0.35f,
+		.yOff = 0.6f,
+		.gridXOff = 3,
+		.gridYOff = 5,
+		.updateInterval = UPDATE_INTERVAL,
+		.updatePhase = 1,
+	};
+	WaterKernelState opaqueState = state;
+	opaqueState.water = referenceWater;
+	WaterKernelSet skyKernels = waterKernelTable[mode][WATER_STYLE_SKY];
+	WaterKernelSet opaqueKernels = waterKernelTable[mode][WATER_STYLE_OPAQUE];
+	WaterKernel kernel = init ? skyKernels.init : skyKernels.step;
+	WaterKernel opaqueKernel = init ? opaqueKernels.init : opaqueKernels.step;
+
+	// The step kernels only update some of the points, the others keep the colors of the init kernels
+	InitGrids();
+	skyKernels.init(&state);
+	opaqueKernels.init(&opaqueState);
+	double start = Seconds();
+	for (int i = 0; i < runs; i++)
+		kernel(&state);
+	double kernelTime = Seconds() - start;
+
+	start = Seconds();
+	for (int i = 0; i < runs; i++)
+		opaqueKernel(&opaqueState);
+	double opaqueTime = Seconds() - start;
+
+	bool valid = true;
+	for (int x = 0; x < WATER_SIZE; x++)
+	{
+		for (int y = 0; y < WATER_SIZE; y++)
+		{
+			const WaterPoint *point = &water[x][y];
+			const WaterPoint *opaque = &referenceWater[x][y];
+			int red = point->color & 31;
+			int green = (point->color >> 5) & 31;
+			int blue = (point->color >> 10) & 31;
+			if (point->height != opaque->height || point->intHeight != opaque->intHeight || point->finalHeight != opaque->finalHeight ||
+				point->color >= 0x8000 || red < 16 || green < 20 || blue != 31)
+				valid = false;
+		}
+	}
+
+	double pointRuns = (double)runs * WATER_SIZE * WATER_SIZE;
+	printf("%-8s sky    %-4s  kernel %7.2f ns/point  opaque    %7.2f ns/point  %s\n",
+		   modeNames[mode], init ? "init" : "step", kernelTime * 1e9 / pointRuns, opaqueTime * 1e9 / pointRuns,
+		   valid ? "valid grid" : "INVALID GRID");
+	return !valid;
+}
+
+/**
+ * @brief Time the step kernel of a mode that has no branching version
+ *
+ */
+static void BenchKernel(WaterMode mode, WaterStyle style, int runs)
+{
+	WaterKernelState state = {
+		.water = water,
+		.sand = sand,
+		.worldX = 12,
+		.worldY = 34,
+		.flow = flow,
+	};
+	WaterKernel kernel = waterKernelTable[mode][style].step;
+
+	InitGrids();
+	double start = Seconds();
+	for (int i = 0; i < runs; i++)
+	{
+		state.time += 24;
+		kernel(&state);
+	}
+	double kernelTime = Seconds() - start;
+
+	double pointRuns = (double)runs * WATER_SIZE * WATER_SIZE;
+	printf("%-8s %-6s step  kernel %7.2f ns/point  no branching version\n",
+		   modeNames[mode], style == WATER_STYLE_CLEAR ? "clear" : style == WATER_STYLE_SKY ? "sky" : "opaque",
+		   kernelTime * 1e9 / pointRuns);
+}
+
+int main(int argc, char **argv)
+{
+	int runs = argc > 1 ? atoi(argv[1]) : DEFAULT_RUNS;
+	int errors = 0;
+	for (int mode = 0; mode < WATER_MODE_COUNT; mode++)
+	{
+		// Added with the kernels, there is no branching version
+		if (mode == WATER_MODE_SIMPLEX || mode == WATER_MODE_FLOW)
+		{
+			for (int style = 0; style < WATER_STYLE_COUNT; style++)
+				BenchKernel(mode, style, runs);
+			continue;
+		}
+
+		for (int clear = 0; clear < 2; clear++)
+			errors += Bench(mode, clear, false, runs);
+		errors += BenchSky(mode, false, runs);
+	}
+	// The init kernels only differ by the color of the Perlin mode
+	for (int clear = 0; clear < 2; clear++)
+	{
+		errors += Bench(WATER_MODE_PERLIN, clear, true, runs / 10);
+		errors += Bench(WATER_MODE_FAST, clear, true, runs / 10);
+	}
+	errors += BenchSky(WATER_MODE_PERLIN, true, runs / 10);
+	errors += BenchSky(WATER_MODE_FAST, true, runs / 10);
+	return errors != 0;
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+// Host benchmark and quality check of the fixed point simplex noise.
+// It times noise2 and noise3 against simplex2 and simplex3, single points and rows,
+// checks that the rows give the same values as the single points, and prints the
+// statistics of every function over the same sample points.
+
+#include "noise.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_ROWS 20000
+#define ROW_SIZE 14
+// Same frequency as the water: a noise unit every 10 points
+#define STEP (4096 / 10)
+#define HISTOGRAM_BINS 8
+
+static double Seconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// Sink for the benchmarked values so the compiler keeps the calls
+static volatile int sink;
+
+typedef struct
+{
+	double sum;
+	double sumSquares;
+	double sumProducts; // Product with the previous point of the row, for the correlation
+	double sumSteps;    // Absolute difference with the previous point of the row
+	int min;
+	int max;
+	long long count;
+	long long pairs;
+	long long histogram[HISTOGRAM_BINS];
+} Stats;
+
+static void StatsAdd(Stats *stats, const int *row, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		int value = row[i];
+		stats->sum += value;
+		stats->sumSquares += (double)value * value;
+		if (value < stats->min)
+			stats->min = value;
+		if (value > stats->max)
+			stats->max = value;
+		int bin = value * HISTOGRAM_BINS / 4097;
+		stats->histogram[bin < 0 ? 0 : bin]++;
+		stats->count++;
+		if (i > 0)
+		{
+			stats->sumProducts += (double)value * row[i - 1];
+			stats->sumSteps += abs(value - row[i - 1]);
+			stats->pairs++;
+		}
+	}
+}
+
+static void StatsPrint(const char *name, const Stats *stats)
+{
+	double mean = stats->sum / stats->count;
+	double variance = stats->sumSquares / stats->count - mean * mean;
+	double correlation = (stats->sumProducts / stats->pairs - mean * mean) / variance;
+	printf("%-9s mean %6.1f  sd %6.1f  range %4d..%4d  neighbour correlation %.3f  mean step %5.1f  histogram",
+		   name, mean, sqrt(variance), stats->min, stats->max, correlation, stats->sumSteps / stats->pairs);
+	for (int i = 0; i < HISTOGRAM_BINS; i++)
+		printf(" %4.1f", 100.0 * stats->histogram[i] / stats->count);
+	printf(" %%\n");
+}
+
+int main(int argc, char **argv)
+{
+	int rows = argc > 1 ? atoi(argv[1]) : DEFAULT_ROWS;
+	int row[ROW_SIZE];
+	int errors = 0;
+	Stats stats[6] = {0};
+	for (int i = 0; i < 6; i++)
+	{
+		stats[i].min = 1 << 30;
+		stats[i].max = -(1 << 30);
+	}
+
+	// Statistics and row checks, the rows start at random points
+	srand(1);
+	for (int r = 0; r < rows; r++)
+	{
+		int x = rand() % (1000 << 12);
+		int y = rand() % (1000 << 12);
+		int z = rand() % (1000 << 12);
+
+		for (int i = 0; i < ROW_SIZE; i++)
+			row[i] = noise2((x + i * STEP) / 4096.0f, y / 4096.0f) * 4096;
+		StatsAdd(&stats[0], row, ROW_SIZE);
+		for (int i = 0; i < ROW_SIZE; i++)
+			row[i] = noise3((x + i * STEP) / 4096.0f, y / 4096.0f, z / 4096.0f) * 2048 + 2048;
+		StatsAdd(&stats[1], row, ROW_SIZE);
+
+		simplex2Row(row, ROW_SIZE, x, y, STEP);
+		StatsAdd(&stats[2], row, ROW_SIZE);
+		for (int i = 0; i < ROW_SIZE; i++)
+			errors += row[i] != simplex2(x + i * STEP, y);
+		simplex3Row(row, ROW_SIZE, x, y, z, STEP);
+		StatsAdd(&stats[3], row, ROW_SIZE);
+		for (int i = 0; i < ROW_SIZE; i++)
+			errors += row[i] != simplex3(x + i * STEP, y, z);
+
+		// Small steps to check that the noise is continuous
+		simplex3Row(row, ROW_SIZE, x, y, z, 16);
+		StatsAdd(&stats[4], row, ROW_SIZE);
+		for (int i = 0; i < ROW_SIZE; i++)
+			row[i] = noise3((x + i * 16) / 4096.0f, y / 4096.0f, z / 4096.0f) * 2048 + 2048;
+		StatsAdd(&stats[5], row, ROW_SIZE);
+	}
+
+	printf("Statistics over %d rows of %d points, values in 20.12 (4096 = 1), noise3 mapped to [0,1]\n", rows, ROW_SIZE);
+	StatsPrint("noise2", &stats[0]);
+	StatsPrint("simplex2", &stats[2]);
+	StatsPrint("noise3", &stats[1]);
+	StatsPrint("simplex3", &stats[3]);
+	printf("Steps of 1/256 to check the continuity\n");
+	StatsPrint("noise3", &stats[5]);
+	StatsPrint("simplex3", &stats[4]);
+	printf("Rows different from single points: %d\n\n", errors);
+
+	// Timings
+	double points = (double)rows * ROW_SIZE;
+	double start = Seconds();
+	for (int r = 0; r < rows; r++)
+	{
+		for (int i = 0; i < ROW_SIZE; i++)
+			sink = noise2((r + i * STEP) / 4096.0f, r / 4096.0f) * 4096;
+	}
+	double noise2Time = Seconds() - start;
+
+	start = Seconds();
+	for (int r = 0; r < rows; r++)
+	{
+		for (int i = 0; i < ROW_SIZE; i++)
+			sink = simplex2(r + i * STEP, r);
+	}
+	double simplex2Time = Seconds() - start;
+
+	start = Seconds();
+	for (int r = 0; r < rows; r++)
+	{
+		simplex2Row(row, ROW_SIZE, r, r, STEP);
+		sink = row[ROW_SIZE - 1];
+	}
+	double simplex2RowTime = Seconds() - start;
+
+	start = Seconds();
+	for (int r = 0; r < rows; r++)
+	{
+		for (int i = 0; i < ROW_SIZE; i++)
+			sink = noise3((r + i * STEP) / 4096.0f, r / 4096.0f, r / 4096.0f) * 4096;
+	}
+	double noise3Time = Seconds() - start;
+
+	start = Seconds();
+	for (int r = 0; r < rows; r++)
+	{
+		for (int i = 0; i < ROW_SIZE; i++)
+			sink = simplex3(r + i * STEP, r, r);
+	}
+	double simplex3Time = Seconds() - start;
+
+	start = Seconds();
+	for (int r = 0; r < rows; r++)
+	{
+		simplex3Row(row, ROW_SIZE, r, r, r, STEP);
+		sink = row[ROW_SIZE - 1];
+	}
+	double simplex3RowTime = Seconds() - start;
+
+	printf("noise2 %6.1f ns  simplex2 %6.1f ns  simplex2Row %6.1f ns per point\n",
+		   noise2Time * 1e9 / points, simplex2Time * 1e9 / points, simplex2RowTime * 1e9 / points);
+	printf("noise3 %6.1f ns  simplex3 %6.1f ns  simplex3Row %6.1f ns per point\n",
+		   noise3Time * 1e9 / points, simplex3Time * 1e9 / points, simplex3RowTime * 1e9 / points);
+	return errors != 0;
+}
@@ -0,0 +1,83 @@
+// Host benchmark of the spray particles.
+// It keeps pools of 256 and 1024 particles full, and reports the time of the update
+// and of the display list build that is sent to the geometry engine on the DS.
+
+#include "particles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_FRAMES 20000
+// Spawn position in the middle of the water grid, going up
+#define SPAWN_POSITION (14 * 4096)
+#define SPAWN_HEIGHT (4 * 4096)
+#define SPAWN_SPEED 200
+
+static double Seconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Run a full pool for some frames and print the timings
+ *
+ * @param capacity
+ * @param frames
+ * @return int 0 if the pool stayed consistent
+ */
+static int Bench(int capacity, int frames)
+{
+	ParticlePool pool;
+	void *buffer = malloc(ParticlesBufferSize(capacity));
+	uint32_t *list = malloc(ParticlesListSize(capacity));
+	if (!buffer || !list)
+	{
+		fprintf(stderr, "Out of memory for %d particles\n", capacity);
+		return 1;
+	}
+	ParticlesInit(&pool, capacity, buffer);
+
+	double updateTime = 0;
+	double buildTime = 0;
+	long long liveParticles = 0;
+	uint32_t checksum = 0;
+	int errors = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		// Refill the pool every frame so the worst case is measured
+		ParticlesSpawn(&pool, SPAWN_POSITION, SPAWN_HEIGHT, SPAWN_POSITION, SPAWN_SPEED, capacity);
+
+		double start = Seconds();
+		ParticlesUpdate(&pool, 1);
+		double updated = Seconds();
+		int words = ParticlesBuildList(&pool, list, 4096, 0);
+		double built = Seconds();
+
+		updateTime += updated - start;
+		buildTime += built - updated;
+		liveParticles += pool.count;
+		checksum += list[words - 1];
+		if (pool.count > capacity || words != 1 + pool.count * PARTICLES_LIST_WORDS_PER_PARTICLE)
+			errors++;
+	}
+
+	printf("%5d particles  %7.1f live  update %7.3f us  list %7.3f us  (%5.2f + %5.2f ns/particle)  %s %08x\n",
+		   capacity, (double)liveParticles / frames,
+		   updateTime * 1e6 / frames, buildTime * 1e6 / frames,
+		   updateTime * 1e9 / liveParticles, buildTime * 1e9 / liveParticles,
+		   errors ? "BROKEN" : "ok", checksum);
+
+	free(buffer);
+	free(list);
+	return errors;
+}
+
+int main(int argc, char **argv)
+{
+	int frames = argc > 1 ? atoi(argv[1]) : DEFAULT_FRAMES;
+	int errors = Bench(256, frames);
+	errors += Bench(1024, frames);
+	return errors != 0;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+// Host benchmark of the shallow water solver of the pipes water mode.
+// It runs the solver on noise terrain with a source and a sink, checks that the
+// volume is conserved and that no depth goes negative, and reports the step time.
+
+#include "pipes.h"
+#include "noise.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_STEPS 2000
+// Same terrain scale as the sand chunks of the game
+#define TERRAIN_FREQUENCY 4.0f
+// Sand height range in water height units, and rest level of the water
+#define TERRAIN_AMPLITUDE 2048
+#define REST_LEVEL 512
+#define SOURCE_RATE 64
+
+static double Seconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Run the solver on a grid and check it
+ *
+ * @param size Width and height of the grid
+ * @param steps
+ * @return int 0 if the checks passed
+ */
+static int Bench(int size, int steps)
+{
+	PipesGrid grid;
+	void *buffer = malloc(PipesBufferSize(size, size));
+	if (!buffer)
+	{
+		fprintf(stderr, "Out of memory for %dx%d\n", size, size);
+		return 1;
+	}
+	PipesInit(&grid, size, size, buffer);
+
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+			grid.terrain[y * size + x] = (noise2((x + 10) / TERRAIN_FREQUENCY, (y + 5) / TERRAIN_FREQUENCY) * 2 - 1) * TERRAIN_AMPLITUDE;
+	}
+	PipesFillToLevel(&grid, REST_LEVEL);
+	PipesAddSource(&grid, 1, 1, SOURCE_RATE);
+	PipesAddSource(&grid, size - 2, size - 2, -SOURCE_RATE);
+
+	int64_t startVolume = PipesVolume(&grid);
+	int errors = 0;
+	double start = Seconds();
+	for (int i = 0; i < steps; i++)
+		PipesStep(&grid);
+	double elapsed = Seconds() - start;
+
+	int64_t volume = PipesVolume(&grid);
+	if (volume != startVolume + grid.addedVolume)
+	{
+		fprintf(stderr, "%dx%d: volume %lld, expected %lld\n", size, size, (long long)volume, (long long)(startVolume + grid.addedVolume));
+		errors++;
+	}
+
+	int dryCells = 0;
+	for (int i = 0; i < size * size; i++)
+	{
+		if (grid.depth[i] < 0)
+		{
+			fprintf(stderr, "%dx%d: negative depth %d in cell %d\n", size, size, grid.depth[i], i);
+			errors++;
+			break;
+		}
+		if (grid.depth[i] == 0)
+			dryCells++;
+	}
+
+	double stepTime = elapsed / steps;
+	printf("%4dx%-4d %6d steps  %9.2f us/step  %6.2f ns/cell  %5.1f%% dry  volume %s\n",
+		   size, size, steps, stepTime * 1e6, stepTime * 1e9 / (size * size),
+		   dryCells * 100.0 / (size * size), errors ? "BROKEN" : "conserved");
+
+	free(buffer);
+	return errors;
+}
+
+int main(int argc, char **argv)
+{
+	int steps = argc > 1 ? atoi(argv[1]) : DEFAULT_STEPS;
+	// The game grid, then bigger grids for the host
+	int sizes[] = {14, 64, 256, 1024};
+	int errors = 0;
+	for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		// Keep the big grids under a few seconds
+		int sizeSteps = steps * 14 / sizes[i];
+		errors += Bench(sizes[i], sizeSteps > 10 ? sizeSteps : 10);
+	}
+	return errors != 0;
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+// Host check of the fixed timestep simulation clock.
+// The VBlanks are counted by calling SimClockVBlank like the interrupt does. It checks the
+// steps and the interpolation alpha at every simulation rate, that no time is lost or added
+// when the frames are late, that a long stall is capped to SIM_CLOCK_MAX_STEPS and drops the
+// extra time, and the rounding of the rates.
+
+#include "simclock.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Frames rendered by the long run of every rate
+#define RUN_FRAMES 6000
+
+static int errors = 0;
+
+static void Check(bool ok, const char *format, int a, int b)
+{
+	if (ok)
+		return;
+	printf("FAILED: ");
+	printf(format, a, b);
+	printf("\n");
+	errors++;
+}
+
+/**
+ * @brief Count VBlanks then advance the clock, like a rendered frame
+ *
+ * @return int Steps to simulate
+ */
+static int Frame(int vblanks)
+{
+	for (int i = 0; i < vblanks; i++)
+		SimClockVBlank();
+	return SimClockAdvance();
+}
+
+/**
+ * @brief Render one frame per VBlank and check the steps and alpha of every frame
+ *
+ */
+static void CheckRate(int stepHz)
+{
+	SimClockInit(stepHz);
+	int stepFrames = 60 / stepHz;
+	int totalSteps = 0;
+	for (int frame = 1; frame <= stepFrames * 10; frame++)
+	{
+		int steps = Frame(1);
+		totalSteps += steps;
+		int phase = frame % stepFrames;
+		Check(steps == (phase == 0), "frame %d: %d steps", frame, steps);
+		Check(simClockAlpha == phase * 4096 / stepFrames, "alpha %d, expected %d", simClockAlpha, phase * 4096 / stepFrames);
+	}
+	Check(totalSteps == 10, "%d Hz: %d steps in 10 periods", stepHz, totalSteps);
+	printf("%2d Hz  %d frames per step  alpha step %4d  steps and alpha ok\n", simClockStepHz, simClockStepFrames, 4096 / stepFrames);
+}
+
+/**
+ * @brief Render frames that take a random number of VBlanks, no time is lost under SIM_CLOCK_MAX_STEPS
+ *
+ */
+static void CheckLateFrames(int stepHz)
+{
+	SimClockInit(stepHz);
+	int vblanks = 0;
+	int totalSteps = 0;
+	int maxSteps = 0;
+	for (int frame = 0; frame < RUN_FRAMES; frame++)
+	{
+		int frameVblanks = 1 + rand() % 3;
+		vblanks += frameVblanks;
+		int steps = Frame(frameVblanks);
+		totalSteps += steps;
+		if (steps > maxSteps)
+			maxSteps = steps;
+	}
+	int simulated = totalSteps * simClockStepFrames + simClockAlpha * simClockStepFrames / 4096;
+	Check(simulated == vblanks, "simulated %d VBlanks of %d", simulated, vblanks);
+	printf("%2d Hz  %d frames of 1 to 3 VBlanks  %d steps, up to %d per frame  %s\n", simClockStepHz, RUN_FRAMES, totalSteps, maxSteps,
+		   simulated == vblanks ? "no time lost" : "TIME LOST");
+}
+
+/**
+ * @brief A stall longer than SIM_CLOCK_MAX_STEPS steps is capped and its extra time is dropped
+ *
+ */
+static void CheckStall()
+{
+	SimClockInit(60);
+	int steps = Frame(100);
+	Check(steps == SIM_CLOCK_MAX_STEPS, "stall: %d steps, expected %d", steps, SIM_CLOCK_MAX_STEPS);
+	steps = Frame(1);
+	Check(steps == 1, "after a stall: %d steps, expected %d", steps, 1);
+
+	// The fraction of a step is kept, only whole steps are dropped
+	SimClockInit(20);
+	Frame(1);
+	steps = Frame(100);
+	Check(steps == SIM_CLOCK_MAX_STEPS, "stall at 20 Hz: %d steps, expected %d", steps, SIM_CLOCK_MAX_STEPS);
+	Check(simClockAlpha == 2 * 4096 / 3, "stall at 20 Hz: alpha %d, expected %d", simClockAlpha, 2 * 4096 / 3);
+	printf("Stall of 100 VBlanks  capped to %d steps, extra time dropped  %s\n", SIM_CLOCK_MAX_STEPS, errors ? "FAILED" : "ok");
+}
+
+/**
+ * @brief The rates are rounded to a divisor of the VBlank rate, the pending time is kept under a step
+ *
+ */
+static void CheckRates()
+{
+	static const int rates[][2] = {{0, 1}, {1, 1}, {25, 30}, {45, 60}, {60, 60}, {120, 60}};
+	for (int i = 0; i < (int)(sizeof(rates) / sizeof(rates[0])); i++)
+	{
+		SimClockSetRate(rates[i][0]);
+		Check(simClockStepHz == rates[i][1], "rate %d rounded to %d", rates[i][0], simClockStepHz);
+	}
+
+	SimClockInit(20);
+	Frame(2);
+	SimClockSetRate(60);
+	int steps = Frame(0);
+	Check(steps == 1 && simClockAlpha == 0, "pending time after a rate change: %d steps, alpha %d", steps, simClockAlpha);
+	printf("Rate rounding and rate changes  %s\n", errors ? "FAILED" : "ok");
+}
+
+int main(void)
+{
+	static const int rates[] = {60, 30, 20, 15};
+	for (int i = 0; i < (int)(sizeof(rates) / sizeof(rates[0])); i++)
+		CheckRate(rates[i]);
+	for (int i = 0; i < (int)(sizeof(rates) / sizeof(rates[0])); i++)
+		CheckLateFrames(rates[i]);
+	CheckStall();
+	CheckRates();
+	return errors != 0;
+}
@@ -0,0 +1,61 @@
+// Host accuracy check of the fixed point sine and cosine.
+// It compares TrigSin, TrigCos, TrigSinLerp and TrigCosLerp with libm on every binary angle,
+// prints the maximum and mean errors in 20.12 units, and fails if an error is above its limit.
+
+#include "trig.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Highest error allowed in 20.12 units: a table step is about 25 units, the interpolation error is below 1 unit plus rounding
+#define TABLE_MAX_ERROR 26
+#define LERP_MAX_ERROR 2
+
+typedef int (*TrigFunction)(int angle);
+
+/**
+ * @brief Compare a function with libm on every angle of a turn, and on angles out of the first turn
+ *
+ * @return int 0 if the maximum error is within the limit
+ */
+static int Check(const char *name, TrigFunction function, double (*reference)(double), int maxError)
+{
+	double maxDifference = 0;
+	double sumDifferences = 0;
+	int worstAngle = 0;
+	for (int angle = 0; angle < TRIG_ANGLE_FULL; angle++)
+	{
+		double expected = reference(angle * 2 * M_PI / TRIG_ANGLE_FULL) * TRIG_ONE;
+		double difference = fabs(function(angle) - expected);
+		sumDifferences += difference;
+		if (difference > maxDifference)
+		{
+			maxDifference = difference;
+			worstAngle = angle;
+		}
+	}
+
+	// Any int is an angle, the result must not change with the turn
+	int wrapErrors = 0;
+	for (int angle = 0; angle < TRIG_ANGLE_FULL; angle += 97)
+	{
+		if (function(angle) != function(angle + 3 * TRIG_ANGLE_FULL) || function(angle) != function(angle - 5 * TRIG_ANGLE_FULL))
+			wrapErrors++;
+	}
+
+	bool ok = maxDifference <= maxError && wrapErrors == 0;
+	printf("%-12s max error %6.2f (angle %5d)  mean error %5.2f  wrap errors %d  %s\n",
+		   name, maxDifference, worstAngle, sumDifferences / TRIG_ANGLE_FULL, wrapErrors, ok ? "ok" : "FAILED");
+	return !ok;
+}
+
+int main(void)
+{
+	int errors = 0;
+	errors += Check("TrigSin", TrigSin, sin, TABLE_MAX_ERROR);
+	errors += Check("TrigCos", TrigCos, cos, TABLE_MAX_ERROR);
+	errors += Check("TrigSinLerp", TrigSinLerp, sin, LERP_MAX_ERROR);
+	errors += Check("TrigCosLerp", TrigCosLerp, cos, LERP_MAX_ERROR);
+	return errors != 0;
+}
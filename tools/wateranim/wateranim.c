@@ -0,0 +1,295 @@
+// Host tool that bakes the looping water animation played by the playback water mode.
+// It writes the coded animation, decodes it back to check it, and reports the
+// compression ratio and the decoding speed.
+
+#include "animcodec.h"
+#include "noise.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_SIZE 14
+#define DEFAULT_FRAME_COUNT 240
+// The animation is played at 60 fps
+#define FRAME_STEP 1
+#define OCTAVE_COUNT 3
+#define MAX_RICE_K 12
+
+typedef struct
+{
+	uint8_t *data;
+	int size;
+	int capacity;
+	uint32_t bits;
+	int count;
+} BitWriter;
+
+static void WriteByte(BitWriter *writer, uint8_t byte)
+{
+	if (writer->size == writer->capacity)
+	{
+		writer->capacity = writer->capacity ? writer->capacity * 2 : 256;
+		writer->data = realloc(writer->data, writer->capacity);
+	}
+	writer->data[writer->size++] = byte;
+}
+
+static void WriteBits(BitWriter *writer, uint32_t value, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		writer->bits |= ((value >> i) & 1) << writer->count;
+		if (++writer->count == 8)
+		{
+			WriteByte(writer, writer->bits);
+			writer->bits = 0;
+			writer->count = 0;
+		}
+	}
+}
+
+static void FlushBits(BitWriter *writer)
+{
+	if (writer->count > 0)
+		WriteByte(writer, writer->bits);
+	writer->bits = 0;
+	writer->count = 0;
+}
+
+static uint32_t Zigzag(int value)
+{
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+// Size in bits of a zigzag value with a rice parameter, must match AnimReadRice
+static int RiceBits(uint32_t zigzag, int k)
+{
+	uint32_t quotient = zigzag >> k;
+	if (quotient >= ANIM_RICE_ESCAPE)
+		return ANIM_RICE_ESCAPE + ANIM_RAW_BITS;
+	return quotient + 1 + k;
+}
+
+static void WriteRice(BitWriter *writer, int value, int k)
+{
+	uint32_t zigzag = Zigzag(value);
+	uint32_t quotient = zigzag >> k;
+	if (quotient >= ANIM_RICE_ESCAPE)
+	{
+		WriteBits(writer, (1u << ANIM_RICE_ESCAPE) - 1, ANIM_RICE_ESCAPE);
+		WriteBits(writer, zigzag, ANIM_RAW_BITS);
+		return;
+	}
+	WriteBits(writer, (1u << quotient) - 1, quotient);
+	WriteBits(writer, 0, 1);
+	WriteBits(writer, zigzag & ((1u << k) - 1), k);
+}
+
+static int BestRiceK(const int *deltas, int count)
+{
+	int bestK = 0;
+	long bestBits = -1;
+	for (int k = 0; k <= MAX_RICE_K; k++)
+	{
+		long bits = 0;
+		for (int i = 0; i < count; i++)
+			bits += RiceBits(Zigzag(deltas[i]), k);
+		if (bestBits < 0 || bits < bestBits)
+		{
+			bestBits = bits;
+			bestK = k;
+		}
+	}
+	return bestK;
+}
+
+static int Clamp(int value, int min, int max)
+{
+	return value < min ? min : value > max ? max : value;
+}
+
+// Heights of a frame in 20.12 fixed point, in the 0 to 1 range of noise2
+static void BakeHeights(int16_t *heights, int size, int frame, int frameCount)
+{
+	const float frequencies[OCTAVE_COUNT] = {0.1f, 0.2f, 0.4f};
+	const float amplitudes[OCTAVE_COUNT] = {0.6f, 0.3f, 0.15f};
+	// Loop periods in noise units, faster for the small details
+	const int periods[OCTAVE_COUNT] = {2, 4, 8};
+	float t = (float)frame / frameCount;
+
+	for (int x = 0; x < size; x++)
+	{
+		for (int y = 0; y < size; y++)
+		{
+			float value = 0;
+			for (int o = 0; o < OCTAVE_COUNT; o++)
+				value += amplitudes[o] * pnoise3(x * frequencies[o] + 17.0f * o, y * frequencies[o], t * periods[o], 256, 256, periods[o]);
+			heights[x * size + y] = Clamp((int)((0.5f + value * 0.6f) * 4096), 0, 4096);
+		}
+	}
+}
+
+// Clear water ramp with a foam highlight on the crests
+static void BakeColors(const int16_t *heights, uint16_t *colors, int size)
+{
+	for (int x = 0; x < size; x++)
+	{
+		for (int y = 0; y < size; y++)
+		{
+			int h = heights[x * size + y];
+			int neighbours = 0;
+			neighbours += heights[Clamp(x - 1, 0, size - 1) * size + y];
+			neighbours += heights[Clamp(x + 1, 0, size - 1) * size + y];
+			neighbours += heights[x * size + Clamp(y - 1, 0, size - 1)];
+			neighbours += heights[x * size + Clamp(y + 1, 0, size - 1)];
+			// Positive on crests
+			int curvature = 4 * h - neighbours;
+			int foam = Clamp(curvature / 256, 0, 8);
+
+			int intensity = h * 11 / 4096;
+			int red = Clamp(intensity + foam, 0, 31);
+			int green = Clamp(intensity + foam, 0, 31);
+			int blue = Clamp(7 + intensity + foam, 0, 31);
+			colors[x * size + y] = red | (green << 5) | (blue << 10);
+		}
+	}
+}
+
+static double Now()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s output.anim [grid size] [frame count]\n", argv[0]);
+		return 1;
+	}
+	const char *path = argv[1];
+	int size = argc > 2 ? atoi(argv[2]) : DEFAULT_SIZE;
+	int frameCount = argc > 3 ? atoi(argv[3]) : DEFAULT_FRAME_COUNT;
+	if (size < 2 || size > 255 || frameCount < 1 || frameCount > 65535)
+	{
+		fprintf(stderr, "Invalid grid size or frame count\n");
+		return 1;
+	}
+
+	int cellCount = size * size;
+	int16_t *heights = calloc(cellCount, sizeof(int16_t));
+	uint16_t *colors = calloc(cellCount, sizeof(uint16_t));
+	int16_t *previousHeights = calloc(cellCount, sizeof(int16_t));
+	uint16_t *previousColors = calloc(cellCount, sizeof(uint16_t));
+	int *heightDeltas = malloc(cellCount * sizeof(int));
+	int *colorDeltas = malloc(cellCount * 3 * sizeof(int));
+	uint32_t *offsets = malloc((frameCount + 1) * sizeof(uint32_t));
+	BitWriter frames = {0};
+
+	// Code every frame
+	uint32_t maxFrameSize = 0;
+	uint32_t dataStart = sizeof(AnimHeader) + (frameCount + 1) * sizeof(uint32_t);
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		BakeHeights(heights, size, frame, frameCount);
+		BakeColors(heights, colors, size);
+
+		for (int i = 0; i < cellCount; i++)
+		{
+			heightDeltas[i] = heights[i] - previousHeights[i];
+			colorDeltas[i * 3] = (colors[i] & 31) - (previousColors[i] & 31);
+			colorDeltas[i * 3 + 1] = ((colors[i] >> 5) & 31) - ((previousColors[i] >> 5) & 31);
+			colorDeltas[i * 3 + 2] = ((colors[i] >> 10) & 31) - ((previousColors[i] >> 10) & 31);
+		}
+
+		int heightK = BestRiceK(heightDeltas, cellCount);
+		int colorK = BestRiceK(colorDeltas, cellCount * 3);
+		offsets[frame] = dataStart + frames.size;
+		WriteByte(&frames, heightK);
+		WriteByte(&frames, colorK);
+		for (int i = 0; i < cellCount; i++)
+		{
+			WriteRice(&frames, heightDeltas[i], heightK);
+			WriteRice(&frames, colorDeltas[i * 3], colorK);
+			WriteRice(&frames, colorDeltas[i * 3 + 1], colorK);
+			WriteRice(&frames, colorDeltas[i * 3 + 2], colorK);
+		}
+		FlushBits(&frames);
+
+		uint32_t frameSize = dataStart + frames.size - offsets[frame];
+		if (frameSize > maxFrameSize)
+			maxFrameSize = frameSize;
+
+		memcpy(previousHeights, heights, cellCount * sizeof(int16_t));
+		memcpy(previousColors, colors, cellCount * sizeof(uint16_t));
+	}
+	offsets[frameCount] = dataStart + frames.size;
+
+	AnimHeader header = {ANIM_MAGIC, ANIM_VERSION, size, size, frameCount, FRAME_STEP, maxFrameSize};
+	FILE *file = fopen(path, "wb");
+	if (!file)
+	{
+		perror(path);
+		return 1;
+	}
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(offsets, sizeof(uint32_t), frameCount + 1, file);
+	fwrite(frames.data, 1, frames.size, file);
+	fclose(file);
+
+	// Decode everything back and compare with a fresh bake
+	memset(heights, 0, cellCount * sizeof(int16_t));
+	memset(colors, 0, cellCount * sizeof(uint16_t));
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		const uint8_t *data = frames.data + offsets[frame] - dataStart;
+		if (AnimDecodeFrame(data, offsets[frame + 1] - offsets[frame], cellCount, heights, colors) != 0)
+		{
+			fprintf(stderr, "Frame %d failed to decode\n", frame);
+			return 1;
+		}
+		BakeHeights(previousHeights, size, frame, frameCount);
+		BakeColors(previousHeights, previousColors, size);
+		if (memcmp(heights, previousHeights, cellCount * sizeof(int16_t)) != 0 || memcmp(colors, previousColors, cellCount * sizeof(uint16_t)) != 0)
+		{
+			fprintf(stderr, "Frame %d does not match after decoding\n", frame);
+			return 1;
+		}
+	}
+
+	// Decoding speed, in decoded grid bytes (height and color) per second
+	int loops = 0;
+	double start = Now();
+	double elapsed = 0;
+	while (elapsed < 0.5)
+	{
+		memset(heights, 0, cellCount * sizeof(int16_t));
+		memset(colors, 0, cellCount * sizeof(uint16_t));
+		for (int frame = 0; frame < frameCount; frame++)
+			AnimDecodeFrame(frames.data + offsets[frame] - dataStart, offsets[frame + 1] - offsets[frame], cellCount, heights, colors);
+		loops++;
+		elapsed = Now() - start;
+	}
+
+	long rawSize = (long)frameCount * cellCount * (sizeof(int16_t) + sizeof(uint16_t));
+	long fileSize = offsets[frameCount];
+	double decodedBytes = (double)rawSize * loops;
+	printf("%s: %dx%d grid, %d frames\n", path, size, size, frameCount);
+	printf("Raw size: %ld bytes, file size: %ld bytes, ratio: %.2f:1\n", rawSize, fileSize, (double)rawSize / fileSize);
+	printf("Average frame: %.1f bytes, biggest frame: %u bytes\n", (double)frames.size / frameCount, maxFrameSize);
+	printf("Decoding: %.1f MB/s\n", decodedBytes / elapsed / 1e6);
+
+	free(heights);
+	free(colors);
+	free(previousHeights);
+	free(previousColors);
+	free(heightDeltas);
+	free(colorDeltas);
+	free(offsets);
+	free(frames.data);
+	return 0;
+}